@@ -0,0 +1,560 @@
+// benchmark and accuracy suite for the horizon kernels of the core library.
+// generates synthetic dems, times the altitude, shade, sunlight, mask,
+// duration and sunrise kernels over sizes, thread counts, azimuths and
+// incFactors, and compares the horizons against an exhaustive reference that
+// samples every step of every transect of the same sampling. results go to
+// stdout (or --out) as csv, one row per run:
+//
+//   horizon_bench [--sizes 256,512] [--threads 1,4] [--azimuths 45,120,200]
+//                 [--inc 1,1.05,1.1] [--dems flat,cone,ridge,fractal,holes]
+//                 [--reps 3] [--reference-max 512] [--out results.csv]
+//
+// the reference is O(n) per cell, so it only runs up to --reference-max
+// cells per side; larger runs leave the error columns empty
+
+#include <sunlight/sunlight.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sunlight;
+
+namespace {
+
+const double resolution = 10; // m per cell
+
+// sun altitudes the shade flags of a kernel are compared to the reference at
+const double shadeAltitudes[] = {2, 5, 10, 15, 20, 30, 40, 50, 60};
+const int nShadeAltitudes = sizeof(shadeAltitudes) / sizeof(shadeAltitudes[0]);
+
+struct Options {
+  std::vector<int> sizes;
+  std::vector<int> threads;
+  std::vector<double> azimuths;
+  std::vector<double> incFactors;
+  std::vector<std::string> dems;
+  int reps;
+  int referenceMax;
+  std::string out;
+};
+
+// value noise on a lattice of period cells, bilinear between lattice points
+double valueNoise(const std::vector<double>& lattice, int latticeSize, double row, double col) {
+  int r = (int)row;
+  int c = (int)col;
+  double fr = row - r;
+  double fc = col - c;
+  double v00 = lattice[(r % latticeSize) * latticeSize + c % latticeSize];
+  double v01 = lattice[(r % latticeSize) * latticeSize + (c + 1) % latticeSize];
+  double v10 = lattice[((r + 1) % latticeSize) * latticeSize + c % latticeSize];
+  double v11 = lattice[((r + 1) % latticeSize) * latticeSize + (c + 1) % latticeSize];
+  return (v00 * (1 - fc) + v01 * fc) * (1 - fr) + (v10 * (1 - fc) + v11 * fc) * fr;
+}
+
+// synthetic dem of size x size cells, column-major, seeded so every run
+// sees the same terrain:
+//   flat     a plane, no cell is ever shaded
+//   cone     a single 800 m peak in the centre
+//   ridge    an east-west ridge with a gentle northward slope
+//   fractal  octaves of value noise, alpine relief of about 2000 m
+//   holes    fractal with NA holes, as voids in a survey
+std::vector<double> makeDem(const std::string& kind, int size) {
+  std::vector<double> dem((std::size_t)size * size, 500);
+  double centre = (size - 1) / 2.0;
+  if (kind == "cone") {
+    for (int col = 0; col < size; col++) {
+      for (int row = 0; row < size; row++) {
+        double distance = std::sqrt((row - centre) * (row - centre) + (col - centre) * (col - centre));
+        dem[(std::size_t)col * size + row] = 500 + std::max(0.0, 800 * (1 - distance / (0.4 * size)));
+      }
+    }
+  } else if (kind == "ridge") {
+    for (int col = 0; col < size; col++) {
+      for (int row = 0; row < size; row++) {
+        double across = (row - centre) / (0.08 * size);
+        dem[(std::size_t)col * size + row] = 500 + 600 * std::exp(-across * across) + 0.5 * (size - row);
+      }
+    }
+  } else if (kind == "fractal" || kind == "holes") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    double amplitude = 1000;
+    for (int period = size / 2; period >= 2; period /= 2) {
+      int latticeSize = size / period + 2;
+      std::vector<double> lattice(latticeSize * latticeSize);
+      for (std::size_t i = 0; i < lattice.size(); i++) {
+        lattice[i] = uniform(generator);
+      }
+      for (int col = 0; col < size; col++) {
+        for (int row = 0; row < size; row++) {
+          dem[(std::size_t)col * size + row] += amplitude * valueNoise(lattice, latticeSize, (double)row / period, (double)col / period);
+        }
+      }
+      amplitude /= 2;
+    }
+    if (kind == "holes") {
+      for (int hole = 0; hole < 12; hole++) {
+        int holeRow = uniform(generator) * size;
+        int holeCol = uniform(generator) * size;
+        int radius = 2 + uniform(generator) * size / 32;
+        for (int col = std::max(0, holeCol - radius); col < std::min(size, holeCol + radius + 1); col++) {
+          for (int row = std::max(0, holeRow - radius); row < std::min(size, holeRow + radius + 1); row++) {
+            if ((row - holeRow) * (row - holeRow) + (col - holeCol) * (col - holeCol) <= radius * radius) {
+              dem[(std::size_t)col * size + row] = NAN;
+            }
+          }
+        }
+      }
+    }
+  }
+  return dem;
+}
+
+// exact horizons, sampling every step of every transect up to the grid edge
+// without any early exit. degrees, 0 where no terrain rises above the cell,
+// as the kernels store them. march rounds a transect per cell, lines and
+// sweep follow the rasterisation of the line through the cell (see
+// LineGeometry): each is held to the reference of its own sampling
+class ReferenceJob {
+public:
+  ReferenceJob(const GridView<const double>& dem, double* output, const AzimuthSteps& steps, bool alongLines) :
+    dem(dem),
+    output(output),
+    steps(steps),
+    lines(steps.dx, steps.dy, dem.nrow, dem.ncol),
+    alongLines(alongLines) {}
+
+  std::size_t size() const {
+    return alongLines ? lines.nLines : dem.ncol;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    for (std::size_t task = begin; task < end; task++) {
+      if (alongLines) {
+        referenceLine(task);
+      } else {
+        referenceColumn(task);
+      }
+    }
+  }
+
+private:
+  void referenceColumn(int col) const {
+    for (int row = 0; row < dem.nrow; row++) {
+      double elevationOrigin = dem(row, col);
+      double best = 0;
+      for (int step = 1; !isNA(elevationOrigin); step++) {
+        int rowStep = row + (int)round(steps.dy * step);
+        int colStep = col + (int)round(steps.dx * step);
+        if (!dem.contains(rowStep, colStep)) {
+          break;
+        }
+        best = std::max(best, (dem(rowStep, colStep) - elevationOrigin) / (steps.dxy * step));
+      }
+      output[(std::size_t)col * dem.nrow + row] = rad2deg(atan(best));
+    }
+  }
+
+  void referenceLine(int line) const {
+    std::vector<int> rows;
+    std::vector<int> cols;
+    for (int t = 0; t < lines.nMajor; t++) {
+      int row, col;
+      if (lines.cell(line, t, row, col)) {
+        rows.push_back(row);
+        cols.push_back(col);
+      }
+    }
+    for (std::size_t i = 0; i < rows.size(); i++) {
+      double elevationOrigin = dem(rows[i], cols[i]);
+      double best = 0;
+      for (std::size_t j = i + 1; j < rows.size() && !isNA(elevationOrigin); j++) {
+        best = std::max(best, (dem(rows[j], cols[j]) - elevationOrigin) / (steps.dxy * (j - i)));
+      }
+      output[(std::size_t)cols[i] * dem.nrow + rows[i]] = rad2deg(atan(best));
+    }
+  }
+
+  GridView<const double> dem;
+  double* output;
+  AzimuthSteps steps;
+  LineGeometry lines;
+  bool alongLines;
+};
+
+// transect steps per cell of the original serial search (as counted by
+// get_altitude_distances_for_azimuth_cpp), over the whole dem
+class StepCountJob {
+public:
+  StepCountJob(const GridView<const double>& dem, double* output, const AzimuthSteps& steps, double incFactor) :
+    dem(dem),
+    output(output),
+    steps(steps),
+    incFactor(incFactor),
+    maxElev(maxElevation(dem)) {}
+
+  std::size_t size() const {
+    return dem.ncol;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    GridView<double> counts(output, dem.nrow, dem.ncol);
+    for (std::size_t col = begin; col < end; col++) {
+      countTransectSteps(dem, counts, col, steps, maxElev, false, incFactor);
+    }
+  }
+
+private:
+  GridView<const double> dem;
+  double* output;
+  AzimuthSteps steps;
+  double incFactor;
+  double maxElev;
+};
+
+// runs job over its range on threads threads, grainSize tasks at a time
+template <typename Job>
+void run(const Job& job, int threads, std::size_t grainSize = 0) {
+  parallelFor(0, job.size(), job, threads, grainSize);
+}
+
+// seconds of the fastest of reps calls of f
+template <typename F>
+double bestTime(int reps, F f) {
+  double best = INFINITY;
+  for (int rep = 0; rep < reps; rep++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// errors of a kernel's horizons (degrees) against the reference
+struct Accuracy {
+  double maxAbsError;
+  double meanAbsError;
+  double shadeMismatch; // share of cells and shadeAltitudes with another shade
+};
+
+Accuracy compare(const std::vector<double>& horizons, const std::vector<double>& reference) {
+  Accuracy accuracy = {0, 0, 0};
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < horizons.size(); i++) {
+    double error = std::fabs(horizons[i] - reference[i]);
+    accuracy.maxAbsError = std::max(accuracy.maxAbsError, error);
+    accuracy.meanAbsError += error;
+    for (int s = 0; s < nShadeAltitudes; s++) {
+      if ((shadeAltitudes[s] < horizons[i]) != (shadeAltitudes[s] < reference[i])) {
+        mismatches++;
+      }
+    }
+  }
+  accuracy.meanAbsError /= horizons.size();
+  accuracy.shadeMismatch = (double)mismatches / (horizons.size() * nShadeAltitudes);
+  return accuracy;
+}
+
+std::FILE* output = stdout;
+
+void writeHeader() {
+  std::fprintf(output, "dem,size,kernel,azimuth,inc_factor,threads,seconds,cells_per_s,steps_per_cell,skipped_per_cell,max_abs_error,mean_abs_error,shade_mismatch\n");
+}
+
+void writeRow(
+    const std::string& dem,
+    int size,
+    const std::string& kernel,
+    double azimuth,
+    double incFactor,
+    int threads,
+    double seconds,
+    double cells,
+    double stepsPerCell,
+    double skippedPerCell,
+    const Accuracy* accuracy
+  ) {
+  std::fprintf(output, "%s,%d,%s,", dem.c_str(), size, kernel.c_str());
+  if (isNA(azimuth)) {
+    std::fprintf(output, ",");
+  } else {
+    std::fprintf(output, "%g,", azimuth);
+  }
+  if (isNA(incFactor)) {
+    std::fprintf(output, ",");
+  } else {
+    std::fprintf(output, "%g,", incFactor);
+  }
+  std::fprintf(output, "%d,%.6f,%.0f,", threads, seconds, cells / seconds);
+  if (isNA(stepsPerCell)) {
+    std::fprintf(output, ",,");
+  } else {
+    std::fprintf(output, "%.3f,%.3f,", stepsPerCell, skippedPerCell);
+  }
+  if (accuracy == NULL) {
+    std::fprintf(output, ",,\n");
+  } else {
+    std::fprintf(output, "%.6f,%.6f,%.6f\n", accuracy->maxAbsError, accuracy->meanAbsError, accuracy->shadeMismatch);
+  }
+  std::fflush(output);
+}
+
+// the altitude kernel variants timed: method, pruning, storage type
+struct Kernel {
+  const char* name;
+  Method method;
+  bool prune;
+  const char* type;
+};
+
+const Kernel kernels[] = {
+  {"march", MARCH, false, "double"},
+  {"march_prune", MARCH, true, "double"},
+  {"march_uint16", MARCH, true, "uint16"},
+  {"lines", LINES, false, "double"},
+  {"sweep", SWEEP, false, "double"}
+};
+
+template <typename T>
+std::vector<double> timeAltitudes(
+    const GridView<const double>& dem,
+    const Kernel& kernel,
+    double azimuth,
+    double incFactor,
+    int threads,
+    int reps,
+    double& seconds,
+    double& skippedPerCell
+  ) {
+  std::vector<T> layer(dem.size());
+  std::vector<double> azimuths(1, azimuth);
+  unsigned long long skipped = 0;
+  seconds = bestTime(reps, [&]() {
+    AltitudeJob<double, T> job(dem, &layer[0], azimuths, 0, resolution, incFactor, kernel.method, kernel.prune);
+    // blocks come heaviest first, hand them out one by one
+    run(job, threads, 1);
+    skipped = job.skippedSteps();
+  });
+  skippedPerCell = (double)skipped / dem.size();
+  std::vector<double> horizons(dem.size());
+  for (std::size_t i = 0; i < layer.size(); i++) {
+    horizons[i] = layer[i] * HorizonType<T>::scale();
+  }
+  return horizons;
+}
+
+void benchDem(const Options& options, const std::string& kind, int size) {
+  std::vector<double> elevations = makeDem(kind, size);
+  GridView<const double> dem(&elevations[0], size, size);
+  double cells = dem.size();
+  for (std::size_t a = 0; a < options.azimuths.size(); a++) {
+    double azimuth = options.azimuths[a];
+    AzimuthSteps steps = getAzimuthSteps(azimuth, 0, resolution);
+    // per cell transects (march) and line rasterisation (lines, sweep)
+    std::vector<double> references[2];
+    if (size <= options.referenceMax) {
+      for (int alongLines = 0; alongLines < 2; alongLines++) {
+        references[alongLines].resize(dem.size());
+        ReferenceJob job(dem, &references[alongLines][0], steps, alongLines);
+        double seconds = bestTime(1, [&]() { run(job, -1); });
+        writeRow(kind, size, alongLines ? "reference_lines" : "reference_march", azimuth, 1, std::thread::hardware_concurrency(), seconds, cells, NAN, NAN, NULL);
+      }
+    }
+    for (std::size_t i = 0; i < options.incFactors.size(); i++) {
+      double incFactor = options.incFactors[i];
+      std::vector<double> counts(dem.size());
+      StepCountJob countJob(dem, &counts[0], steps, incFactor);
+      run(countJob, -1);
+      double stepsPerCell = 0;
+      for (std::size_t c = 0; c < counts.size(); c++) {
+        stepsPerCell += counts[c];
+      }
+      stepsPerCell /= cells;
+      for (std::size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        const Kernel& kernel = kernels[k];
+        // sweep is exact along each line, incFactor does not apply
+        if (kernel.method == SWEEP && incFactor != options.incFactors[0]) {
+          continue;
+        }
+        for (std::size_t t = 0; t < options.threads.size(); t++) {
+          double seconds, skippedPerCell;
+          std::vector<double> horizons;
+          if (std::strcmp(kernel.type, "uint16") == 0) {
+            horizons = timeAltitudes<uint16_t>(dem, kernel, azimuth, incFactor, options.threads[t], options.reps, seconds, skippedPerCell);
+          } else {
+            horizons = timeAltitudes<double>(dem, kernel, azimuth, incFactor, options.threads[t], options.reps, seconds, skippedPerCell);
+          }
+          const std::vector<double>& reference = references[kernel.method == MARCH ? 0 : 1];
+          Accuracy accuracy = {0, 0, 0};
+          if (!reference.empty()) {
+            accuracy = compare(horizons, reference);
+          }
+          writeRow(
+            kind, size, kernel.name, azimuth, kernel.method == SWEEP ? NAN : incFactor, options.threads[t],
+            seconds, cells, kernel.method == SWEEP ? NAN : stepsPerCell, skippedPerCell,
+            reference.empty() ? NULL : &accuracy
+          );
+        }
+      }
+    }
+  }
+
+  // shade and sunlight of one layer, serially and in parallel
+  std::vector<double> layer(dem.size());
+  AltitudeJob<double, double> layerJob(dem, &layer[0], std::vector<double>(1, 180.0), 0, resolution, 1, SWEEP);
+  run(layerJob, -1);
+  std::vector<double> flags(dem.size());
+  std::vector<uint64_t> mask(maskWords(dem.size()));
+  for (std::size_t t = 0; t < options.threads.size(); t++) {
+    ThresholdJob<double> shadeJob(&layer[0], dem.size(), 20, false, &flags[0]);
+    double seconds = bestTime(options.reps, [&]() { run(shadeJob, options.threads[t]); });
+    writeRow(kind, size, "shades", 180, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+    ThresholdJob<double> sunlightJob(&layer[0], dem.size(), 20, true, &flags[0]);
+    seconds = bestTime(options.reps, [&]() { run(sunlightJob, options.threads[t]); });
+    writeRow(kind, size, "sunlight", 180, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+    ThresholdJob<double> maskJob(&layer[0], dem.size(), 20, false, &mask[0]);
+    seconds = bestTime(options.reps, [&]() { run(maskJob, options.threads[t]); });
+    writeRow(kind, size, "shade_mask", 180, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+  }
+
+  // a year of 10 minute sun positions over a cube of 2 degree azimuths
+  std::vector<double> cubeAzimuths;
+  for (double azimuth = 40; azimuth <= 320; azimuth += 2) {
+    cubeAzimuths.push_back(azimuth);
+  }
+  std::vector<uint16_t> cube(cubeAzimuths.size() * dem.size());
+  AltitudeJob<double, uint16_t> cubeJob(dem, &cube[0], cubeAzimuths, 0, resolution, 1, MARCH, true);
+  run(cubeJob, -1);
+  std::vector<SunSample> samples = getSunSamples(1672531200, 1704067200, 600, 10, 45, 6, cubeAzimuths[0], 2, cubeAzimuths.size());
+  std::vector<double> durations(dem.size());
+  for (std::size_t t = 0; t < options.threads.size(); t++) {
+    double seconds = bestTime(options.reps, [&]() {
+      std::fill(durations.begin(), durations.end(), 0);
+      DurationJob<uint16_t> job(&cube[0], dem.size(), 1, cubeAzimuths.size(), samples, &durations[0]);
+      run(job, options.threads[t]);
+    });
+    writeRow(kind, size, "durations_year", NAN, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+  }
+
+  // the sunlight masks of a midsummer day, and their durations
+  std::vector<SunSample> day = getSunSamples(1687305600, 1687392000, 600, 10, 45, 6, cubeAzimuths[0], 2, cubeAzimuths.size());
+  std::vector<uint64_t> masks(maskWords(dem.size()) * day.size());
+  for (std::size_t t = 0; t < options.threads.size(); t++) {
+    MaskCubeJob<uint16_t> masksJob(&cube[0], dem.size(), 1, cubeAzimuths.size(), day, true, &masks[0]);
+    double seconds = bestTime(options.reps, [&]() { run(masksJob, options.threads[t]); });
+    writeRow(kind, size, "day_masks", NAN, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+    MaskDurationJob countJob(&masks[0], day.size(), dem.size(), 10, &durations[0]);
+    seconds = bestTime(options.reps, [&]() { run(countJob, options.threads[t]); });
+    writeRow(kind, size, "day_mask_durations", NAN, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+  }
+
+  // the same day from the crossings of the sun's track with the horizons
+  std::vector<TrackKnot> track = getSunTrack(1687305600, 1687392000, 45, 6, cubeAzimuths[0], 2, cubeAzimuths.size());
+  std::vector<double> sunrise(dem.size()), sunset(dem.size());
+  for (std::size_t t = 0; t < options.threads.size(); t++) {
+    SunriseJob<uint16_t> sunriseJob(&cube[0], dem.size(), 1, cubeAzimuths.size(), track, &sunrise[0], &sunset[0], &durations[0]);
+    double seconds = bestTime(options.reps, [&]() { run(sunriseJob, options.threads[t]); });
+    writeRow(kind, size, "day_crossings", NAN, NAN, options.threads[t], seconds, cells, NAN, NAN, NULL);
+  }
+}
+
+std::vector<std::string> splitList(const char* list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+template <typename T>
+std::vector<T> parseList(const char* list) {
+  std::vector<std::string> items = splitList(list);
+  std::vector<T> values;
+  for (std::size_t i = 0; i < items.size(); i++) {
+    values.push_back((T)std::atof(items[i].c_str()));
+  }
+  return values;
+}
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: horizon_bench [--sizes 256,512] [--threads 1,4] [--azimuths 45,120,200]\n"
+    "                     [--inc 1,1.05,1.1] [--dems flat,cone,ridge,fractal,holes]\n"
+    "                     [--reps 3] [--reference-max 512] [--out results.csv]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.sizes = parseList<int>("256,512");
+  options.threads = std::vector<int>(1, 1);
+  int hardwareThreads = std::thread::hardware_concurrency();
+  if (hardwareThreads > 1) {
+    options.threads.push_back(hardwareThreads);
+  }
+  options.azimuths = parseList<double>("45,120,200");
+  options.incFactors = parseList<double>("1,1.05,1.1");
+  options.dems = splitList("flat,cone,ridge,fractal,holes");
+  options.reps = 3;
+  options.referenceMax = 512;
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char* value = argv[++i];
+    if (flag == "--sizes") {
+      options.sizes = parseList<int>(value);
+    } else if (flag == "--threads") {
+      options.threads = parseList<int>(value);
+    } else if (flag == "--azimuths") {
+      options.azimuths = parseList<double>(value);
+    } else if (flag == "--inc") {
+      options.incFactors = parseList<double>(value);
+    } else if (flag == "--dems") {
+      options.dems = splitList(value);
+    } else if (flag == "--reps") {
+      options.reps = std::max(1, std::atoi(value));
+    } else if (flag == "--reference-max") {
+      options.referenceMax = std::atoi(value);
+    } else if (flag == "--out") {
+      options.out = value;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (!options.out.empty()) {
+    output = std::fopen(options.out.c_str(), "w");
+    if (output == NULL) {
+      std::fprintf(stderr, "cannot write %s\n", options.out.c_str());
+      return 1;
+    }
+  }
+  writeHeader();
+  for (std::size_t d = 0; d < options.dems.size(); d++) {
+    for (std::size_t s = 0; s < options.sizes.size(); s++) {
+      benchDem(options, options.dems[d], options.sizes[s]);
+    }
+  }
+  if (output != stdout) {
+    std::fclose(output);
+  }
+  return 0;
+}
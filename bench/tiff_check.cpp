@@ -0,0 +1,180 @@
+// round trip of the GeoTIFF writer: writes layers of each sample type with
+// each compression, whole and as a window, reads them back as libtiff does
+// (undoing the predictor only inside a codec) and compares the samples.
+// prints one line per file and exits with 1 on a mismatch:
+//
+//   tiff_check [directory]
+
+#include <sunlight/sunlight.h>
+#include <sunlight/tiff.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace sunlight;
+
+namespace {
+
+// the value of tag in the directory of file (first value for arrays), or
+// all values with values
+uint32_t readTag(const std::vector<unsigned char>& file, uint16_t tag, std::vector<uint32_t>* values = NULL) {
+  uint32_t directory;
+  std::memcpy(&directory, &file[4], 4);
+  uint16_t count;
+  std::memcpy(&count, &file[directory], 2);
+  for (int e = 0; e < count; e++) {
+    const unsigned char* entry = &file[directory + 2 + 12 * e];
+    uint16_t entryTag, type;
+    uint32_t n;
+    std::memcpy(&entryTag, entry, 2);
+    std::memcpy(&type, entry + 2, 2);
+    std::memcpy(&n, entry + 4, 4);
+    if (entryTag != tag) {
+      continue;
+    }
+    std::size_t size = type == 3 ? 2 : 4;
+    const unsigned char* data = entry + 8;
+    if (n * size > 4) {
+      uint32_t offset;
+      std::memcpy(&offset, entry + 8, 4);
+      data = &file[offset];
+    }
+    std::vector<uint32_t> all(n);
+    for (uint32_t i = 0; i < n; i++) {
+      uint16_t shortValue;
+      if (size == 2) {
+        std::memcpy(&shortValue, data + 2 * i, 2);
+        all[i] = shortValue;
+      } else {
+        std::memcpy(&all[i], data + 4 * i, 4);
+      }
+    }
+    if (values) {
+      *values = all;
+    }
+    return all[0];
+  }
+  throw std::runtime_error("missing tag");
+}
+
+// samples of the file at path, row by row
+template <typename S>
+std::vector<S> readTiff(const std::string& path) {
+  std::vector<unsigned char> file;
+  FILE* in = std::fopen(path.c_str(), "rb");
+  if (!in) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  unsigned char buffer[65536];
+  std::size_t n;
+  while ((n = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    file.insert(file.end(), buffer, buffer + n);
+  }
+  std::fclose(in);
+  int ncol = readTag(file, 256);
+  int nrow = readTag(file, 257);
+  uint32_t compression = readTag(file, 259);
+  uint32_t predictor = readTag(file, 317);
+  int tileSize = readTag(file, 322);
+  std::vector<uint32_t> offsets, byteCounts;
+  readTag(file, 324, &offsets);
+  readTag(file, 325, &byteCounts);
+  int tilesAcross = (ncol + tileSize - 1) / tileSize;
+  std::vector<S> samples((std::size_t)nrow * ncol);
+  std::vector<S> tile((std::size_t)tileSize * tileSize);
+  for (std::size_t t = 0; t < offsets.size(); t++) {
+    if (compression == TIFF_NONE) {
+      std::memcpy(&tile[0], &file[offsets[t]], tile.size() * sizeof(S));
+    } else {
+      uLongf size = tile.size() * sizeof(S);
+      if (uncompress(reinterpret_cast<unsigned char*>(&tile[0]), &size, &file[offsets[t]], byteCounts[t]) != Z_OK) {
+        throw std::runtime_error("cannot inflate " + path);
+      }
+      // the predictor belongs to the codec
+      if (predictor == 2) {
+        for (int r = 0; r < tileSize; r++) {
+          for (int c = 1; c < tileSize; c++) {
+            tile[(std::size_t)r * tileSize + c] = (S)(tile[(std::size_t)r * tileSize + c] + tile[(std::size_t)r * tileSize + c - 1]);
+          }
+        }
+      }
+    }
+    int tileRow = t / tilesAcross;
+    int tileCol = t % tilesAcross;
+    for (int r = 0; r < tileSize && tileRow * tileSize + r < nrow; r++) {
+      for (int c = 0; c < tileSize && tileCol * tileSize + c < ncol; c++) {
+        samples[(std::size_t)(tileRow * tileSize + r) * ncol + tileCol * tileSize + c] = tile[(std::size_t)r * tileSize + c];
+      }
+    }
+  }
+  return samples;
+}
+
+// writes window of a cube of nAzimuths layers of T, layer a, to path and
+// compares it read back, returning whether it matches
+template <typename T>
+bool check(const std::string& path, const std::vector<T>& cube, int nAzimuths, int a, int nrow, const TiffWindow& window, TiffCompression compression) {
+  typedef typename TiffSample<T>::type S;
+  Georeference georeference = {1000, 9000, 5, 5};
+  writeGeoTiff(path, &cube[a], nAzimuths, nrow, window, georeference, 2154, compression, 64);
+  std::vector<S> samples = readTiff<S>(path);
+  int mismatches = 0;
+  for (int r = 0; r < window.nrow; r++) {
+    for (int c = 0; c < window.ncol; c++) {
+      S expected = (S)cube[a + (std::size_t)nAzimuths * (window.row + r + (std::size_t)nrow * (window.col + c))];
+      if (samples[(std::size_t)r * window.ncol + c] != expected) {
+        mismatches++;
+      }
+    }
+  }
+  std::printf("%s: %s\n", path.c_str(), mismatches ? "MISMATCH" : "ok");
+  return mismatches == 0;
+}
+
+// a cube of nAzimuths layers of horizons of T, varying along rows and columns
+template <typename T>
+std::vector<T> makeCube(int nAzimuths, int nrow, int ncol) {
+  std::vector<T> cube((std::size_t)nAzimuths * nrow * ncol);
+  for (std::size_t i = 0; i < cube.size(); i++) {
+    cube[i] = HorizonType<T>::quantize(45 + 40 * std::sin(i * 0.013) * std::cos(i * 0.0007));
+  }
+  return cube;
+}
+
+template <typename T>
+bool checkType(const std::string& directory, const std::string& name) {
+  int nAzimuths = 3, nrow = 150, ncol = 170;
+  std::vector<T> cube = makeCube<T>(nAzimuths, nrow, ncol);
+  TiffWindow all = {0, 0, nrow, ncol};
+  TiffWindow stripe = {0, 100, nrow, 70};
+  const TiffCompression compressions[] = {TIFF_NONE, TIFF_DEFLATE};
+  const char* compressionNames[] = {"none", "deflate"};
+  bool ok = true;
+  for (int k = 0; k < 2; k++) {
+    std::string prefix = directory + "/tiff_check_" + name + "_" + compressionNames[k];
+    ok &= check(prefix + ".tif", cube, nAzimuths, 1, nrow, all, compressions[k]);
+    ok &= check(prefix + "_stripe.tif", cube, nAzimuths, 2, nrow, stripe, compressions[k]);
+  }
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string directory = argc > 1 ? argv[1] : ".";
+  bool ok = true;
+  try {
+    ok &= checkType<double>(directory, "flt4s");
+    ok &= checkType<uint16_t>(directory, "int2u");
+    ok &= checkType<uint8_t>(directory, "int1u");
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return ok ? 0 : 1;
+}
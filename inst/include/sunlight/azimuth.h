@@ -0,0 +1,158 @@
+#ifndef SUNLIGHT_AZIMUTH_H
+#define SUNLIGHT_AZIMUTH_H
+
+#include <cmath>
+#include "util.h"
+
+namespace sunlight {
+
+// row and column offset dx, dy for one step along an azimuth, and the length
+// dxy of that step in m
+struct AzimuthSteps {
+  double dx;
+  double dy;
+  double dxy;
+};
+
+inline AzimuthSteps getAzimuthSteps(
+    double azimuth,
+    double gridConvergence,
+    double resolution
+  ) {
+  double azi = dmod((azimuth + gridConvergence), 360);
+  // steps x and y as factor
+  double dx = 1;
+  double dy = 1;
+  // figure out effective angle for step calculation
+  double aziRel = dmod(azi,90);
+  if (aziRel > 45) {
+    aziRel = 90 - aziRel;
+  }
+  double dopp = tan(deg2rad(aziRel));
+
+  // NNE
+  if (azi <= 45) {
+    dx = dopp;
+    dy = -1;
+  // NEE
+  } else if ((azi > 45) & (azi <= 90)) {
+    //    dx = 1;
+    dy = dopp * -1;
+  // SEE
+  } else if ((azi > 90) & (azi <= 135)) {
+    //  dx = 1;
+    dy = dopp;
+  // SSE
+  } else if ((azi > 135) & (azi <= 180)) {
+    dx = dopp;
+    // dy = 1;
+  // SSW
+  } else if  ((azi > 180) & (azi <= 225)) {
+    dx = dopp * -1;
+    // dy = 1;
+  // SWW
+  } else if  ((azi > 225) & (azi <= 270)) {
+    dx = -1;
+    dy = dopp;
+  // NWW
+  } else if  ((azi > 270) & (azi <= 315)) {
+    dx = -1;
+    dy = dopp * -1;
+  // NNW
+  } else if (azi > 315) {
+    dx = dopp * -1;
+    dy = -1;
+  }
+
+  // dxy = distance of sampling steps in m
+  double dxy = sqrt(pow(dx, 2) + pow(dy, 2)) * resolution;
+  AzimuthSteps steps = {dx, dy, dxy};
+  return steps;
+}
+
+// the grid decomposed into parallel lines along the azimuth. every cell lies
+// on exactly one line; t counts steps along a line towards the sun, so the
+// transect of a cell is the remainder of its line beyond it
+struct LineGeometry {
+  bool rowMajor; // lines advance one row per step (else one column)
+  int majorSign;
+  int minorSign;
+  double slope; // minor offset per major step, between 0 and 1
+  int nMajor;
+  int nMinor;
+  int minorSpan; // minor offset accumulated over the whole major extent
+  int nLines;
+
+  LineGeometry(double dx, double dy, int height, int width) {
+    rowMajor = std::fabs(dy) >= std::fabs(dx);
+    double major = rowMajor ? dy : dx;
+    double minor = rowMajor ? dx : dy;
+    majorSign = major > 0 ? 1 : -1;
+    minorSign = minor < 0 ? -1 : 1;
+    slope = std::fabs(minor) / std::fabs(major);
+    nMajor = rowMajor ? height : width;
+    nMinor = rowMajor ? width : height;
+    minorSpan = minorOffset(nMajor - 1);
+    nLines = nMinor + minorSpan;
+  }
+
+  int minorOffset(int t) const {
+    return (int)std::floor(t * slope + 0.5);
+  }
+
+  // row/col of step t on line, false if the line is outside the grid there
+  bool cell(int line, int t, int& row, int& col) const {
+    int start = minorSign > 0 ? line - minorSpan : line;
+    int q = start + minorSign * minorOffset(t);
+    if (q < 0 || q >= nMinor) {
+      return false;
+    }
+    int m = majorSign > 0 ? t : nMajor - 1 - t;
+    row = rowMajor ? m : q;
+    col = rowMajor ? q : m;
+    return true;
+  }
+
+  // number of steps of line inside the grid, which are consecutive: the
+  // minor offset only ever grows along a line
+  int length(int line) const {
+    int start = minorSign > 0 ? line - minorSpan : line;
+    // steps before the line enters the grid, and before it leaves it
+    int lo = 0;
+    int hi = nMajor;
+    while (lo < hi) {
+      int t = (lo + hi) / 2;
+      int q = start + minorSign * minorOffset(t);
+      if (minorSign > 0 ? q < 0 : q >= nMinor) {
+        lo = t + 1;
+      } else {
+        hi = t;
+      }
+    }
+    int first = lo;
+    hi = nMajor;
+    while (lo < hi) {
+      int t = (lo + hi) / 2;
+      int q = start + minorSign * minorOffset(t);
+      if (minorSign > 0 ? q < nMinor : q >= 0) {
+        lo = t + 1;
+      } else {
+        hi = t;
+      }
+    }
+    return lo - first;
+  }
+
+  // the line through cell (row, col), inverse of cell()
+  int line(int row, int col) const {
+    int m = rowMajor ? row : col;
+    int q = rowMajor ? col : row;
+    int t = majorSign > 0 ? m : nMajor - 1 - m;
+    int start = q - minorSign * minorOffset(t);
+    return minorSign > 0 ? start + minorSpan : start;
+  }
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef SUNLIGHT_DURATION_H
+#define SUNLIGHT_DURATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "mask.h"
+#include "quantization.h"
+#include "ranges.h"
+#include "solar.h"
+#include "util.h"
+
+namespace sunlight {
+
+// the sun in the azimuth bin of altitude layer `layer` at `altitude` degrees,
+// for `weight` time units (e.g. minutes of a timestep), at `time` (seconds
+// since the epoch) if known
+struct SunSample {
+  int layer;
+  double altitude;
+  double weight;
+  double time;
+};
+
+// index k of the nearest of the azimuths azimuthMin + k * azimuthStep
+// (k < nAzimuths) to azimuth, wrapping around north, or -1 if azimuth is more
+// than half a step outside their range
+inline int getAzimuthLayer(double azimuth, double azimuthMin, double azimuthStep, int nAzimuths) {
+  double offset = dmod(azimuth - azimuthMin, 360);
+  if (offset < 0) {
+    offset += 360;
+  }
+  int layer = floor(offset / azimuthStep + 0.5);
+  if (layer >= nAzimuths) {
+    layer = floor((offset - 360) / azimuthStep + 0.5);
+  }
+  return layer >= 0 && layer < nAzimuths ? layer : -1;
+}
+
+// sun samples of the daylight timesteps in [timeStart, timeStop), every
+// timestep seconds and each weighing weight, at location lat/lon. samples go
+// to the layer with the nearest azimuth (see getAzimuthLayer); samples more
+// than half a step outside the layers' range are dropped
+inline std::vector<SunSample> getSunSamples(
+    double timeStart,
+    double timeStop,
+    double timestep,
+    double weight,
+    double lat,
+    double lon,
+    double azimuthMin,
+    double azimuthStep,
+    int nAzimuths
+  ) {
+  std::vector<SunSample> samples;
+  for (long step = 0; timeStart + step * timestep < timeStop; step++) {
+    double time = timeStart + step * timestep;
+    SunPosition position = getSunPosition(time, lat, lon);
+    if (position.altitude < sunriseAltitude) {
+      continue;
+    }
+    int layer = getAzimuthLayer(position.azimuth, azimuthMin, azimuthStep, nAzimuths);
+    if (layer >= 0) {
+      SunSample sample = {layer, position.altitude, weight, time};
+      samples.push_back(sample);
+    }
+  }
+  return samples;
+}
+
+// total sunlight per cell over a list of sun samples, in one pass over the
+// cells: samples are grouped per layer and sorted by threshold, so the
+// samples in which a cell is lit (the sun not below its horizon) are a
+// suffix of its layer's group, found by binary search and summed through
+// precomputed suffix weights. layer l of cell i is at
+// altitudes[l * layerStride + i * cellStride], durations[i] is added to.
+// samples with an NA altitude are ignored. with ranges of the layers (see
+// HorizonRanges), the search of a cell is narrowed to the samples within
+// the range of its tile, and a tile the sun is outside the range of in
+// every sample gets the same total without reading its cells
+template <typename T>
+class DurationJob {
+public:
+  typedef typename HorizonType<T>::threshold_type threshold_type;
+
+  DurationJob(
+      const T* altitudes,
+      std::size_t nCells,
+      std::ptrdiff_t layerStride,
+      std::ptrdiff_t cellStride,
+      std::vector<SunSample> samples,
+      double* durations,
+      const HorizonRanges<T>* ranges = NULL
+    ) :
+    altitudes(altitudes),
+    nCells(nCells),
+    layerStride(layerStride),
+    cellStride(cellStride),
+    durations(durations),
+    ranges(ranges) {
+    samples.erase(std::remove_if(samples.begin(), samples.end(), isNASample), samples.end());
+    std::sort(samples.begin(), samples.end(), bySunAltitude);
+    for (std::size_t s = 0; s < samples.size(); s++) {
+      if (s == 0 || samples[s].layer != samples[s - 1].layer) {
+        Bin bin = {samples[s].layer, thresholds.size()};
+        bins.push_back(bin);
+      }
+      thresholds.push_back(HorizonType<T>::threshold(samples[s].altitude));
+      weights.push_back(samples[s].weight);
+    }
+    // suffix sums per bin, weights[k] becomes the weight of samples k.. of
+    // its bin, with a trailing 0 at every bin end
+    std::vector<double> suffix;
+    for (std::size_t b = 0; b < bins.size(); b++) {
+      std::size_t end = binEnd(b);
+      std::size_t start = suffix.size();
+      suffix.resize(start + end - bins[b].start + 1, 0);
+      for (std::size_t k = end; k > bins[b].start; k--) {
+        suffix[start + k - 1 - bins[b].start] = suffix[start + k - bins[b].start] + weights[k - 1];
+      }
+    }
+    weights.swap(suffix);
+  }
+
+  std::size_t size() const {
+    return nCells;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    if (ranges) {
+      accumulateTiles(begin, end);
+      return;
+    }
+    for (std::size_t i = begin; i < end; i++) {
+      const T* cell = altitudes + i * cellStride;
+      double total = 0;
+      for (std::size_t b = 0; b < bins.size(); b++) {
+        const threshold_type* first = &thresholds[0] + bins[b].start;
+        const threshold_type* last = &thresholds[0] + binEnd(b);
+        // lit unless threshold < altitude
+        std::size_t lit = std::lower_bound(first, last, cell[bins[b].layer * layerStride]) - first;
+        total += weights[bins[b].start + b + lit];
+      }
+      durations[i] += total;
+    }
+  }
+
+private:
+  struct Bin {
+    int layer;
+    std::size_t start; // first threshold of the bin
+  };
+
+  void accumulateTiles(std::size_t begin, std::size_t end) const {
+    // lit counts per bin of the lowest and highest horizon of the tile of
+    // the previous cell: a cell's count lies between them. NA compares as
+    // below every threshold, lit as in the cell search
+    std::vector<std::size_t> low(bins.size()), high(bins.size());
+    std::size_t tile = (std::size_t)-1;
+    bool uniform = false;
+    double tileTotal = 0;
+    for (std::size_t i = begin; i < end;) {
+      std::size_t runEnd = ranges->runEnd(i, end);
+      std::size_t index = ranges->index(i, 0);
+      if (index != tile) {
+        tile = index;
+        uniform = true;
+        tileTotal = 0;
+        for (std::size_t b = 0; b < bins.size(); b++) {
+          const threshold_type* first = &thresholds[0] + bins[b].start;
+          const threshold_type* last = &thresholds[0] + binEnd(b);
+          low[b] = std::lower_bound(first, last, ranges->mins[tile + bins[b].layer]) - first;
+          high[b] = std::lower_bound(first, last, ranges->maxs[tile + bins[b].layer]) - first;
+          uniform = uniform && low[b] == high[b];
+          tileTotal += weights[bins[b].start + b + low[b]];
+        }
+      }
+      if (uniform) {
+        for (; i < runEnd; i++) {
+          durations[i] += tileTotal;
+        }
+        continue;
+      }
+      for (; i < runEnd; i++) {
+        const T* cell = altitudes + i * cellStride;
+        double total = 0;
+        for (std::size_t b = 0; b < bins.size(); b++) {
+          std::size_t lit = low[b];
+          if (high[b] != low[b]) {
+            const threshold_type* first = &thresholds[0] + bins[b].start;
+            lit = std::lower_bound(first + low[b], first + high[b], cell[bins[b].layer * layerStride]) - first;
+          }
+          total += weights[bins[b].start + b + lit];
+        }
+        durations[i] += total;
+      }
+    }
+  }
+
+  static bool isNASample(const SunSample& sample) {
+    return isNA(sample.altitude);
+  }
+
+  static bool bySunAltitude(const SunSample& a, const SunSample& b) {
+    return a.layer < b.layer || (a.layer == b.layer && a.altitude < b.altitude);
+  }
+
+  std::size_t binEnd(std::size_t b) const {
+    return b + 1 < bins.size() ? bins[b + 1].start : thresholds.size();
+  }
+
+  const T* altitudes;
+  std::size_t nCells;
+  std::ptrdiff_t layerStride;
+  std::ptrdiff_t cellStride;
+  double* durations;
+  std::vector<Bin> bins;
+  std::vector<threshold_type> thresholds;
+  std::vector<double> weights; // suffix sums, one extra entry per bin
+  const HorizonRanges<T>* ranges;
+};
+
+// a bit-packed mask (see mask.h) per sun sample, in the order of the
+// samples, of the cells shaded with the sun there or, with sunlight, lit:
+// mask s is at masks[s * maskWords(nCells)]. layer l of cell i is at
+// altitudes[l * layerStride + i * cellStride]. a task is a word of cells
+// across all samples, so the layers of its cells are read while in cache.
+// samples with an NA altitude get empty masks
+template <typename T>
+class MaskCubeJob {
+public:
+  MaskCubeJob(
+      const T* altitudes,
+      std::size_t nCells,
+      std::ptrdiff_t layerStride,
+      std::ptrdiff_t cellStride,
+      const std::vector<SunSample>& samples,
+      bool sunlight,
+      uint64_t* masks
+    ) :
+    altitudes(altitudes),
+    nCells(nCells),
+    nWords(maskWords(nCells)),
+    layerStride(layerStride),
+    cellStride(cellStride),
+    samples(samples),
+    sunlight(sunlight),
+    masks(masks) {}
+
+  std::size_t size() const {
+    return nWords;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    for (std::size_t w = begin; w < end; w++) {
+      for (std::size_t s = 0; s < samples.size(); s++) {
+        uint64_t* mask = masks + s * nWords;
+        if (isNA(samples[s].altitude)) {
+          mask[w] = 0;
+          continue;
+        }
+        thresholdMask(
+            altitudes + samples[s].layer * layerStride, cellStride, nCells,
+            HorizonType<T>::threshold(samples[s].altitude), sunlight, mask, w, w + 1);
+      }
+    }
+  }
+
+private:
+  const T* altitudes;
+  std::size_t nCells;
+  std::size_t nWords;
+  std::ptrdiff_t layerStride;
+  std::ptrdiff_t cellStride;
+  std::vector<SunSample> samples;
+  bool sunlight;
+  uint64_t* masks;
+};
+
+} // namespace sunlight
+
+#endif
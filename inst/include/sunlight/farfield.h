@@ -0,0 +1,258 @@
+#ifndef SUNLIGHT_FARFIELD_H
+#define SUNLIGHT_FARFIELD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "azimuth.h"
+#include "grid.h"
+#include "horizon.h"
+#include "quantization.h"
+#include "util.h"
+
+namespace sunlight {
+
+// distant terrain at a coarser resolution: a horizon run covers its dem
+// (the near field) with transects up to a reach, and far fields, coarser
+// dems around it over a larger extent, take the transects on from there,
+// each from its own distance on and stepping at its own resolution. so
+// mountains far outside the study area still cast their shadows at low sun,
+// without a huge dem at full resolution or fine steps across it. all dems
+// share the projection and vertical datum
+
+// a far field, read by transects from distance (m) on, up to the distance
+// of the next one, and before that wherever they have left the finer grids.
+// its cells are taken as square, xres wide
+template <typename E>
+struct FarField {
+  GridView<const E> dem;
+  Georeference georeference;
+  double distance;
+};
+
+// the samples of a far field's transects of one azimuth up to the distance
+// of the next field: offsets in steps, relative to an origin anywhere in the
+// grid
+struct FarTransect {
+  AzimuthSteps steps; // in cells of the far field
+  std::vector<int> stepFactors;
+  std::vector<double> distances;
+  std::vector<double> drops;
+  double maxElev;
+};
+
+// raises the horizons a near field run wrote to output, laid out as by
+// AltitudeJob (output[a + nAzimuths * (row + nrow * col)]), to the horizons
+// of the far fields, so that each is the horizon over the transect read
+// from the finest grid that holds it: the dem up to the reach of the run (the
+// distance of the first far field), then each far field from its distance.
+// a far sample is the far cell nearest to where the transect passes, step
+// factors grow with incFactor as in TransectTemplate. cells whose near
+// horizon is above the far terrain stop at once; cells stored as
+// neverSunlit, or whose horizon passes the cap of the azimuth (see
+// AltitudeJob), stay or become neverSunlit. tasks are a column of one
+// azimuth each, so any parallel loop over [0, size()) can run it
+template <typename E, typename T>
+class FarFieldJob {
+public:
+  FarFieldJob(
+      const GridView<const E>& dem,
+      const Georeference& georeference,
+      const std::vector<FarField<E> >& fields,
+      T* output,
+      const std::vector<double>& azimuths,
+      double gridConvergence,
+      double incFactor,
+      bool correctCurvature = false,
+      bool correctRefraction = false,
+      const std::vector<double>& altitudeCaps = std::vector<double>()
+    ) :
+    dem(dem),
+    georeference(georeference),
+    fields(fields),
+    output(output),
+    azimuths(azimuths) {
+    if (!altitudeCaps.empty() && altitudeCaps.size() != azimuths.size()) {
+      throw std::invalid_argument("altitudeCaps must have one cap per azimuth");
+    }
+    for (std::size_t f = 1; f < fields.size(); f++) {
+      if (!(fields[f].distance > fields[f - 1].distance)) {
+        throw std::invalid_argument("far fields must be ordered by increasing distance");
+      }
+    }
+    for (std::size_t a = 0; a < azimuths.size(); a++) {
+      caps.push_back(altitudeCaps.empty() ? INFINITY : getCapTangent<T>(altitudeCaps[a]));
+      for (std::size_t f = 0; f < fields.size(); f++) {
+        double until = f + 1 < fields.size() ? fields[f + 1].distance : INFINITY;
+        transects.push_back(farTransect(fields[f], azimuths[a], gridConvergence, incFactor, until, correctCurvature, correctRefraction));
+      }
+    }
+  }
+
+  std::size_t size() const {
+    return azimuths.size() * dem.ncol;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    for (std::size_t task = begin; task < end; task++) {
+      for (int row = 0; row < dem.nrow; row++) {
+        raise(task / dem.ncol, row, task % dem.ncol);
+      }
+    }
+  }
+
+  // raises the horizon of cell (row, col) for azimuth a, as stored by a near
+  // field run, to that of the far fields. UpdateJob calls it for the cells
+  // it recomputes
+  void raise(std::size_t a, int row, int col) const {
+    T& stored = output[a + azimuths.size() * (row + (std::size_t)dem.nrow * col)];
+    double elevationOrigin = dem(row, col);
+    if (isNA(elevationOrigin) || stored >= HorizonType<T>::quantize(neverSunlit)) {
+      return;
+    }
+    double x = georeference.xmin + (col + 0.5) * georeference.xres;
+    double y = georeference.ymax - (row + 0.5) * georeference.yres;
+    // just below the near horizon, so far terrain as high as it still
+    // counts and the stored horizon never drops
+    double best = tan(deg2rad(stored * HorizonType<T>::scale())) * (1 - 1e-9);
+    double near = best;
+    for (std::size_t f = 0; f < fields.size() && best <= caps[a]; f++) {
+      best = searchFarField(f, transects[a * fields.size() + f], x, y, elevationOrigin, best, caps[a]);
+    }
+    if (best > near) {
+      T far = storedHorizon<T>(best, caps[a]);
+      stored = std::max(stored, far);
+    }
+  }
+
+private:
+  static FarTransect farTransect(
+      const FarField<E>& field,
+      double azimuth,
+      double gridConvergence,
+      double incFactor,
+      double until,
+      bool correctCurvature,
+      bool correctRefraction
+    ) {
+    FarTransect transect;
+    transect.steps = getAzimuthSteps(azimuth, gridConvergence, field.georeference.xres);
+    transect.maxElev = maxElevation(field.dem);
+    // from anywhere in the grid, no sample beyond max(nrow, ncol) is inside
+    int maxStepFactor = std::max(field.dem.nrow, field.dem.ncol);
+    int step = 0;
+    while (true) {
+      double next = step + pow(incFactor, step + 1);
+      if (next > maxStepFactor || transect.steps.dxy * (int)next >= until) {
+        break;
+      }
+      int stepFactor = next;
+      step++;
+      double distance = transect.steps.dxy * stepFactor;
+      double drop = 0;
+      if (correctCurvature) {
+        drop = correctRefraction ? getRefractedCurvatureCorrection(distance) : getCurvatureCorrection(distance);
+      }
+      transect.stepFactors.push_back(stepFactor);
+      transect.distances.push_back(distance);
+      transect.drops.push_back(drop);
+    }
+    return transect;
+  }
+
+  // whether the sample of field f at distance, short of the distance of f,
+  // centred on map position (x, y) was read from a finer grid: the one whose
+  // distances hold it, if it lies within, or else one between that and f
+  bool finerHolds(std::size_t f, double distance, double x, double y) const {
+    // grids from fine to coarse: 0 the dem, g the far field g - 1
+    std::size_t g = 0;
+    while (g < f && fields[g].distance <= distance) {
+      g++;
+    }
+    int row;
+    int col;
+    for (; g <= f; g++) {
+      const Georeference& grid = g == 0 ? georeference : fields[g - 1].georeference;
+      int nrow = g == 0 ? dem.nrow : fields[g - 1].dem.nrow;
+      int ncol = g == 0 ? dem.ncol : fields[g - 1].dem.ncol;
+      if (gridCellAt(x, y, grid.xmin, grid.ymax, grid.xres, grid.yres, nrow, ncol, row, col)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // horizon tangent from map position (x, y) at elevationOrigin over the
+  // samples of transect in field f, given the best tangent so far
+  double searchFarField(
+      std::size_t f,
+      const FarTransect& transect,
+      double x,
+      double y,
+      double elevationOrigin,
+      double best,
+      double cap
+    ) const {
+    const FarField<E>& field = fields[f];
+    const Georeference& grid = field.georeference;
+    // the origin in cells of the far field and its offset from the centre,
+    // 0 on grids aligned with it so that samples round as in the near field
+    double originRow = (grid.ymax - y) / grid.yres - 0.5;
+    double originCol = (x - grid.xmin) / grid.xres - 0.5;
+    int rowOrigin = round(originRow);
+    int colOrigin = round(originCol);
+    double rowShift = snapToCentre(originRow - rowOrigin);
+    double colShift = snapToCentre(originCol - colOrigin);
+    bool entered = false;
+    for (std::size_t k = 0; k < transect.stepFactors.size(); k++) {
+      double distance = transect.distances[k];
+      double drop = transect.drops[k];
+      if ((transect.maxElev - drop - elevationOrigin) / distance <= best) {
+        // no higher altitude is feasible
+        break;
+      }
+      int row = rowOrigin + (int)round(rowShift + transect.steps.dy * transect.stepFactors[k]);
+      int col = colOrigin + (int)round(colShift + transect.steps.dx * transect.stepFactors[k]);
+      if (!field.dem.contains(row, col)) {
+        if (entered) {
+          break;
+        }
+        continue;
+      }
+      entered = true;
+      if (distance < field.distance &&
+          finerHolds(f, distance, grid.xmin + (col + 0.5) * grid.xres, grid.ymax - (row + 0.5) * grid.yres)) {
+        continue;
+      }
+      double elevDiffStep = field.dem(row, col) - elevationOrigin - drop;
+      if (elevDiffStep > 0) {
+        double tangent = elevDiffStep / distance;
+        if (tangent > best) {
+          best = tangent;
+          if (best > cap) {
+            break;
+          }
+        }
+      }
+    }
+    return best;
+  }
+
+  static double snapToCentre(double shift) {
+    return std::fabs(shift) < 1e-6 ? 0 : shift;
+  }
+
+  GridView<const E> dem;
+  Georeference georeference;
+  std::vector<FarField<E> > fields;
+  T* output;
+  std::vector<double> azimuths;
+  std::vector<double> caps; // tangents
+  std::vector<FarTransect> transects; // per azimuth and field
+};
+
+} // namespace sunlight
+
+#endif
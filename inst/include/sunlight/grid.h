@@ -0,0 +1,109 @@
+#ifndef SUNLIGHT_GRID_H
+#define SUNLIGHT_GRID_H
+
+#include <cmath>
+#include <cstddef>
+#include "util.h"
+
+namespace sunlight {
+
+// non-owning view of a 2d grid in a contiguous buffer with explicit strides,
+// cell (row, col) lives at data[row * rowStride + col * colStride]. a
+// column-major R matrix has rowStride 1 and colStride nrow
+template <typename T>
+struct GridView {
+  T* data;
+  int nrow;
+  int ncol;
+  std::ptrdiff_t rowStride;
+  std::ptrdiff_t colStride;
+
+  GridView(T* data, int nrow, int ncol, std::ptrdiff_t rowStride, std::ptrdiff_t colStride) :
+    data(data),
+    nrow(nrow),
+    ncol(ncol),
+    rowStride(rowStride),
+    colStride(colStride) {}
+
+  // column-major, as R lays out matrices
+  GridView(T* data, int nrow, int ncol) :
+    data(data),
+    nrow(nrow),
+    ncol(ncol),
+    rowStride(1),
+    colStride(nrow) {}
+
+  // e.g. a read-only view of a writable grid
+  template <typename U>
+  GridView(const GridView<U>& other) :
+    data(other.data),
+    nrow(other.nrow),
+    ncol(other.ncol),
+    rowStride(other.rowStride),
+    colStride(other.colStride) {}
+
+  T& operator()(int row, int col) const {
+    return data[row * rowStride + col * colStride];
+  }
+
+  bool contains(int row, int col) const {
+    return row >= 0 && row < nrow && col >= 0 && col < ncol;
+  }
+
+  std::size_t size() const {
+    return (std::size_t)nrow * ncol;
+  }
+};
+
+// highest elevation of a dem, ignoring NA cells (-Inf if there are none)
+template <typename E>
+double maxElevation(const GridView<const E>& dem) {
+  double maxElev = -INFINITY;
+  for (int col = 0; col < dem.ncol; col++) {
+    for (int row = 0; row < dem.nrow; row++) {
+      double elevation = dem(row, col);
+      if (elevation > maxElev) {
+        maxElev = elevation;
+      }
+    }
+  }
+  return maxElev;
+}
+
+// position of a grid in map coordinates: the left and top edge of the grid
+// and the width and height of its cells
+struct Georeference {
+  double xmin;
+  double ymax;
+  double xres;
+  double yres;
+};
+
+// row and column of the cell containing map coordinates (x, y) in an nrow x
+// ncol grid whose top left corner is at (xmin, ymax) and whose cells are
+// xres wide and yres high, false outside the grid
+inline bool gridCellAt(
+    double x,
+    double y,
+    double xmin,
+    double ymax,
+    double xres,
+    double yres,
+    int nrow,
+    int ncol,
+    int& row,
+    int& col
+  ) {
+  double c = std::floor((x - xmin) / xres);
+  double r = std::floor((ymax - y) / yres);
+  if (!(r >= 0 && r < nrow && c >= 0 && c < ncol)) {
+    return false;
+  }
+  row = r;
+  col = c;
+  return true;
+}
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,678 @@
+#ifndef SUNLIGHT_HORIZON_H
+#define SUNLIGHT_HORIZON_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "azimuth.h"
+#include "grid.h"
+#include "pyramid.h"
+#include "quantization.h"
+#include "schedule.h"
+#include "stats.h"
+#include "transect.h"
+#include "util.h"
+
+namespace sunlight {
+
+// march: per cell transects read from the dem
+// lines: the same transects read from contiguous line buffers
+// sweep: exact single pass per line
+enum Method {
+  MARCH,
+  LINES,
+  SWEEP
+};
+
+inline Method parseMethod(const std::string& method) {
+  if (method == "march") {
+    return MARCH;
+  } else if (method == "lines") {
+    return LINES;
+  } else if (method == "sweep") {
+    return SWEEP;
+  }
+  throw std::invalid_argument("unknown method: " + method);
+}
+
+// E is the element type of the dem (double or float), T the storage type of
+// the altitudes (see quantization.h)
+
+// transects are searched on tangents, rise over distance: the tangent of the
+// horizon is the largest among the samples, and since rad2deg(atan()) is
+// monotonic its angle is the largest sample angle, so a single atan per cell
+// gives the same result as comparing angles per sample. the distance is kept
+// as a divisor rather than a reciprocal so the tangents round the same way
+
+// with a sun envelope, each azimuth has a cap, the highest the sun ever gets
+// there (see getMaxSunAltitude). once a horizon rises above it the cell is
+// never sunlit from that azimuth, the search stops and the cell stores
+// neverSunlit instead of its angle, which shades it for every sun just the
+// same. caps are kept as tangents, infinite without an envelope
+const double neverSunlit = 90;
+
+// tangent cap of azimuths whose sun never gets above cap degrees, for
+// storage type T: above it the stored horizon shades every sun up to cap
+template <typename T>
+double getCapTangent(double cap) {
+  if (isNA(cap)) {
+    return INFINITY;
+  }
+  double shadedAbove = HorizonType<T>::shadedAbove(cap) + 1e-9;
+  if (shadedAbove >= 90) {
+    return INFINITY;
+  } else if (shadedAbove <= -90) {
+    return -INFINITY;
+  }
+  return tan(deg2rad(shadedAbove));
+}
+
+// horizon tangent best as stored
+template <typename T>
+T storedHorizon(double best, double cap) {
+  return HorizonType<T>::quantize(best > cap ? neverSunlit : rad2deg(atan(best)));
+}
+
+// rise over distance below which terrain cannot beat the horizon tangent
+// best any more; the margin keeps pruning clear of the rounding of the
+// division, so pruned results stay bit-identical
+inline double pruneReach(double best, double distance) {
+  return best * distance * (1 - 1e-9);
+}
+
+// horizon tangent of cell (row, col) with elevation elevationOrigin, from
+// sample k to sample n of its transect, given the best tangent so far. with
+// a pyramid, samples inside blocks whose maximum cannot beat it are skipped
+// and the search stops once the whole grid cannot, the samples left counted
+// as skipped too; without one, only the global maxElev bounds the search.
+// the search also stops as soon as the tangent passes cap. counters get the
+// samples read and skipped, and how the search of the cell ended
+template <typename E>
+double searchTransect(
+    const GridView<const E>& dem,
+    int row,
+    int col,
+    double elevationOrigin,
+    const TransectTemplate& transect,
+    int k,
+    int n,
+    double best,
+    double maxElev,
+    const MaxPyramid* pyramid,
+    SearchCounters& counters,
+    double cap = INFINITY
+  ) {
+  if (best > cap) {
+    counters.earlyBreaks++;
+    return best;
+  }
+  const E* origin = &dem(row, col);
+  // block being skipped, if any
+  int skipLevel = 0;
+  int skipRow = 0;
+  int skipCol = 0;
+  for (; k < n; k++) {
+    double distance = transect.distances[k];
+    double drop = transect.drops[k];
+    if (pyramid) {
+      int rowStep = row + transect.rowOffsets[k];
+      int colStep = col + transect.colOffsets[k];
+      if (skipLevel > 0 && (rowStep >> skipLevel) == skipRow && (colStep >> skipLevel) == skipCol) {
+        counters.skipped++;
+        continue;
+      }
+      // largest block around the sample that cannot raise the horizon,
+      // distances only grow further on
+      double reach = pruneReach(best, distance);
+      skipLevel = 0;
+      while (skipLevel < pyramid->levels() &&
+             pyramid->blockMax(skipLevel + 1, rowStep, colStep) - elevationOrigin - drop <= reach) {
+        skipLevel++;
+      }
+      if (skipLevel == pyramid->levels()) {
+        counters.skipped += n - k;
+        break;
+      } else if (skipLevel > 0) {
+        skipRow = rowStep >> skipLevel;
+        skipCol = colStep >> skipLevel;
+        counters.skipped++;
+        continue;
+      }
+    }
+    counters.steps++;
+    double elevDiffStep = origin[transect.offsets[k]] - elevationOrigin - drop;
+    if (elevDiffStep > 0) {
+      double tangent = elevDiffStep / distance;
+      if (tangent > best) {
+        best = tangent;
+        if (best > cap) {
+          break;
+        }
+      } else if ((maxElev - drop - elevationOrigin) / distance < best) {
+        // no higher altitude is feasible
+        break;
+      }
+    }
+  }
+  if (k < n) {
+    counters.earlyBreaks++;
+  } else {
+    counters.edgeExits++;
+  }
+  return best;
+}
+
+// cells per lane group of marchColumn, a multiple of any simd width, and the
+// first pyramid level whose blocks are as high as a group
+const int marchLanes = 8;
+const int groupLevel = 3;
+
+// ray marching: walks a fresh, sub-sampled transect for every cell of a
+// column. consecutive rows of a column share the transect template and sit
+// next to each other in a column-major dem, so groups of marchLanes cells
+// advance through their samples together, reading the dem contiguously in a
+// loop the compiler can vectorise. once a lane leaves the grid or is done,
+// the group is finished cell by cell through searchTransect. with a
+// pyramid, the group skips blocks that cannot raise the horizon of any of
+// its cells. lanes above cap are done. rows [rowBegin, rowEnd) of the
+// column are marched
+template <typename E, typename T>
+void marchColumn(
+    const GridView<const E>& dem,
+    const GridView<T>& layer,
+    int col,
+    int rowBegin,
+    int rowEnd,
+    const TransectTemplate& transect,
+    double maxElev,
+    const MaxPyramid* pyramid,
+    SearchCounters& counters,
+    double cap = INFINITY
+  ) {
+  const int nLanes = marchLanes;
+  int row = rowBegin;
+  for (; row + nLanes <= rowEnd; row += nLanes) {
+    double origin[nLanes];
+    double best[nLanes];
+    int done[nLanes];
+    int n[nLanes];
+    int common = transect.size();
+    int live = 0;
+    for (int j = 0; j < nLanes; j++) {
+      origin[j] = dem(row + j, col);
+      best[j] = 0;
+      done[j] = isNA(origin[j]) | (best[j] > cap);
+      n[j] = transect.samples(row + j, col, dem.nrow, dem.ncol);
+      common = std::min(common, n[j]);
+      live += !done[j];
+    }
+    const E* base = &dem(row, col);
+    std::ptrdiff_t stride = dem.rowStride;
+    int skipLevel = 0;
+    int skipTop = 0;
+    int skipBottom = 0;
+    int skipCol = 0;
+    int k = 0;
+    for (; k < common && live > 0; k++) {
+      double distance = transect.distances[k];
+      double drop = transect.drops[k];
+      if (pyramid) {
+        int top = row + transect.rowOffsets[k];
+        int bottom = top + nLanes - 1;
+        int colStep = col + transect.colOffsets[k];
+        if (skipLevel > 0 && (top >> skipLevel) == skipTop && (bottom >> skipLevel) == skipBottom &&
+            (colStep >> skipLevel) == skipCol) {
+          counters.skipped += live;
+          continue;
+        }
+        // largest blocks covering the group's samples that cannot raise the
+        // horizon of any live lane; from groupLevel on, the samples span at
+        // most two blocks per level
+        skipLevel = 0;
+        for (int level = groupLevel; level <= pyramid->levels(); level++) {
+          double blockMax = std::max(pyramid->blockMax(level, top, colStep), pyramid->blockMax(level, bottom, colStep));
+          bool below = true;
+          for (int j = 0; j < nLanes; j++) {
+            if (!done[j] && blockMax - origin[j] - drop > pruneReach(best[j], distance)) {
+              below = false;
+            }
+          }
+          if (!below) {
+            break;
+          }
+          skipLevel = level;
+        }
+        if (skipLevel == pyramid->levels()) {
+          for (int j = 0; j < nLanes; j++) {
+            counters.skipped += done[j] ? 0 : n[j] - k;
+          }
+          live = 0;
+          break;
+        } else if (skipLevel > 0) {
+          skipTop = top >> skipLevel;
+          skipBottom = bottom >> skipLevel;
+          skipCol = colStep >> skipLevel;
+          counters.skipped += live;
+          continue;
+        }
+      }
+      const E* sample = base + transect.offsets[k];
+      double bound = maxElev - drop;
+      counters.steps += live;
+      live = 0;
+      for (int j = 0; j < nLanes; j++) {
+        double elevDiffStep = sample[j * stride] - origin[j] - drop;
+        double tangent = elevDiffStep / distance;
+        int rise = !done[j] & (elevDiffStep > 0);
+        int higher = rise & (tangent > best[j]);
+        // no higher altitude is feasible
+        done[j] |= rise & !higher & ((bound - origin[j]) / distance < best[j]);
+        best[j] = higher ? tangent : best[j];
+        done[j] |= best[j] > cap;
+        live += !done[j];
+      }
+    }
+    for (int j = 0; j < nLanes; j++) {
+      if (isNA(origin[j])) {
+        counters.naCells++;
+      } else if (!done[j] && live > 0) {
+        best[j] = searchTransect(dem, row + j, col, origin[j], transect, k, n[j], best[j], maxElev, pyramid, counters, cap);
+      } else {
+        counters.earlyBreaks++;
+      }
+      layer(row + j, col) = storedHorizon<T>(best[j], cap);
+    }
+  }
+  // remaining rows one by one
+  for (; row < rowEnd; row++) {
+    double elevationOrigin = dem(row, col);
+    double best = 0;
+    if (!isNA(elevationOrigin)) {
+      int n = transect.samples(row, col, dem.nrow, dem.ncol);
+      best = searchTransect(dem, row, col, elevationOrigin, transect, 0, n, best, maxElev, pyramid, counters, cap);
+    } else {
+      counters.naCells++;
+    }
+    layer(row, col) = storedHorizon<T>(best, cap);
+  }
+}
+
+// scratch memory of one thread, reused across lines
+struct LineBuffers {
+  std::vector<double> elevations;
+  std::vector<int> rows;
+  std::vector<int> cols;
+  std::vector<int> hullT;
+  std::vector<double> hullZ;
+  std::vector<double> aheadMax;
+};
+
+// ray marching on line buffers: the dem along a line is gathered into
+// contiguous memory first, so transects read sequentially whatever the
+// azimuth, and the results are scattered back afterwards. samples the same
+// steps as marchColumn, but along the line's own rasterisation. with prune,
+// the maximum of the rest of the line stops a transect as soon as nothing
+// ahead can raise the horizon; counters.skipped gets the samples left unread.
+// transects stop above cap
+template <typename E, typename T>
+void marchLine(
+    const GridView<const E>& dem,
+    const GridView<T>& layer,
+    int line,
+    const LineGeometry& lines,
+    const TransectTemplate& transect,
+    double maxElev,
+    bool prune,
+    LineBuffers& buffers,
+    SearchCounters& counters,
+    double cap = INFINITY
+  ) {
+  std::vector<double>& elevations = buffers.elevations;
+  elevations.clear();
+  buffers.rows.clear();
+  buffers.cols.clear();
+  for (int t = 0; t < lines.nMajor; t++) {
+    int row, col;
+    if (lines.cell(line, t, row, col)) {
+      elevations.push_back(dem(row, col));
+      buffers.rows.push_back(row);
+      buffers.cols.push_back(col);
+    }
+  }
+  int n = elevations.size();
+  std::vector<double>& aheadMax = buffers.aheadMax;
+  if (prune) {
+    aheadMax.assign(n + 1, -INFINITY);
+    for (int i = n - 1; i >= 0; i--) {
+      aheadMax[i] = elevations[i] > aheadMax[i + 1] ? elevations[i] : aheadMax[i + 1];
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    double elevationOrigin = elevations[i];
+    double best = 0;
+    if (isNA(elevationOrigin)) {
+      counters.naCells++;
+    } else if (best > cap) {
+      counters.earlyBreaks++;
+    } else {
+      // traverse transect to find max altitude difference
+      bool early = false;
+      for (int k = 0; k < transect.size() && i + transect.stepFactors[k] < n; k++) {
+        int stepFactor = transect.stepFactors[k];
+        double distance = transect.distances[k];
+        double drop = transect.drops[k];
+        if (prune && aheadMax[i + stepFactor] - elevationOrigin - drop <= pruneReach(best, distance)) {
+          // the samples of the template left on the line
+          int last = std::upper_bound(transect.stepFactors.begin() + k, transect.stepFactors.end(), n - 1 - i) - transect.stepFactors.begin();
+          counters.skipped += last - k;
+          early = true;
+          break;
+        }
+        counters.steps++;
+        double elevDiffStep = elevations[i + stepFactor] - elevationOrigin - drop;
+        if (elevDiffStep > 0) {
+          double tangent = elevDiffStep / distance;
+          if (tangent > best) {
+            best = tangent;
+            if (best > cap) {
+              early = true;
+              break;
+            }
+          } else if ((maxElev - drop - elevationOrigin) / distance < best) {
+            // no higher altitude is feasible
+            early = true;
+            break;
+          }
+        }
+      }
+      if (early) {
+        counters.earlyBreaks++;
+      } else {
+        counters.edgeExits++;
+      }
+    }
+    layer(buffers.rows[i], buffers.cols[i]) = storedHorizon<T>(best, cap);
+  }
+}
+
+// exact horizon per line in a single pass: walking each line from the sun
+// side, the upper convex hull of the terrain profile seen so far holds every
+// point that can still be the horizon for a cell further back. being a
+// single pass anyway, the sweep only applies cap to what it stores
+template <typename E, typename T>
+void sweepLine(
+    const GridView<const E>& dem,
+    const GridView<T>& layer,
+    int line,
+    const LineGeometry& lines,
+    double dxy,
+    LineBuffers& buffers,
+    SearchCounters& counters,
+    double cap = INFINITY
+  ) {
+  std::vector<int>& hullT = buffers.hullT;
+  std::vector<double>& hullZ = buffers.hullZ;
+  hullT.clear();
+  hullZ.clear();
+  for (int t = lines.nMajor - 1; t >= 0; t--) {
+    int row, col;
+    if (!lines.cell(line, t, row, col)) {
+      continue;
+    }
+    double elevationOrigin = dem(row, col);
+    double best = 0;
+    if (!isNA(elevationOrigin)) {
+      // drop hull points hidden behind their successor as seen from here
+      while (hullT.size() >= 2) {
+        counters.steps++;
+        std::size_t last = hullT.size() - 1;
+        double riseA = hullZ[last] - elevationOrigin;
+        double riseB = hullZ[last - 1] - elevationOrigin;
+        if (riseA * (hullT[last - 1] - t) <= riseB * (hullT[last] - t)) {
+          hullT.pop_back();
+          hullZ.pop_back();
+        } else {
+          break;
+        }
+      }
+      if (!hullT.empty()) {
+        double elevDiff = hullZ.back() - elevationOrigin;
+        if (elevDiff > 0) {
+          double distance = dxy * (hullT.back() - t);
+          best = elevDiff / distance;
+        }
+      }
+      hullT.push_back(t);
+      hullZ.push_back(elevationOrigin);
+    } else {
+      counters.naCells++;
+    }
+    layer(row, col) = storedHorizon<T>(best, cap);
+  }
+}
+
+// horizon angles of a dem for a list of azimuths, written azimuth-major into
+// output, i.e. output[a + nAzimuths * (row + nrow * col)]. the work is split
+// into independent tasks, blocks of one azimuth of about grainSize cells
+// ordered heaviest first (see WorkBlock), so any parallel loop over
+// [0, size()) can run it, best one handing out tasks dynamically; buffers
+// are local to each call, so concurrent calls on disjoint ranges are safe.
+// prune bounds the march and lines searches by the local terrain maxima
+// ahead (see MaxPyramid) instead of the global one, with identical results.
+// correctCurvature lowers distant terrain by the earth's curvature, less the
+// standard refraction with correctRefraction; sweep cannot follow that drop,
+// so corrected sweeps run as lines with incFactor 1 instead. altitudeCaps,
+// if not empty, holds the sun envelope cap of each azimuth in degrees (NaN
+// for none), see neverSunlit. summary, if not NULL, is the summary of dem
+// kept by the caller, used instead of scanning the dem again. march and
+// lines transects end before reach (m), where a FarFieldJob takes over;
+// sweep always reads whole lines
+template <typename E, typename T>
+class AltitudeJob {
+public:
+  AltitudeJob(
+      const GridView<const E>& dem,
+      T* output,
+      const std::vector<double>& azimuths,
+      double gridConvergence,
+      double resolution,
+      double incFactor,
+      Method method,
+      bool prune = false,
+      bool correctCurvature = false,
+      bool correctRefraction = false,
+      const std::vector<double>& altitudeCaps = std::vector<double>(),
+      const DemSummary* summary = NULL,
+      double reach = INFINITY
+    ) :
+    dem(dem),
+    output(output),
+    method(method),
+    prune(prune),
+    stats(NULL),
+    skipped(0) {
+    if (!altitudeCaps.empty() && altitudeCaps.size() != azimuths.size()) {
+      throw std::invalid_argument("altitudeCaps must have one cap per azimuth");
+    }
+    maxElev = summary ? summary->maxElev : maxElevation(dem);
+    if (correctCurvature && method == SWEEP) {
+      this->method = method = LINES;
+      incFactor = 1;
+    }
+    if (prune && method == MARCH) {
+      if (summary && summary->pyramid) {
+        pyramid = summary->pyramid;
+      } else {
+        pyramid.reset(new MaxPyramid(dem));
+      }
+    }
+    for (std::size_t a = 0; a < azimuths.size(); a++) {
+      steps.push_back(getAzimuthSteps(azimuths[a], gridConvergence, resolution));
+      lines.push_back(LineGeometry(steps[a].dx, steps[a].dy, dem.nrow, dem.ncol));
+      // shared by all cells (march, lines), unused by sweep
+      transects.push_back(TransectTemplate(
+          steps[a], incFactor, dem.nrow, dem.ncol, dem.rowStride, dem.colStride,
+          correctCurvature, correctRefraction, reach));
+      caps.push_back(altitudeCaps.empty() ? INFINITY : getCapTangent<T>(altitudeCaps[a]));
+    }
+    plan(defaultGrainSize);
+  }
+
+  std::size_t size() const {
+    return blocks.size();
+  }
+
+  // cut the runs into blocks of about cells cells instead, the default for
+  // 0; size() changes, so not while the job runs
+  void setGrainSize(int cells) {
+    plan(cells > 0 ? cells : defaultGrainSize);
+  }
+
+  // output layer of azimuth a
+  GridView<T> layer(std::size_t a) const {
+    std::ptrdiff_t nAzimuths = steps.size();
+    return GridView<T>(output + a, dem.nrow, dem.ncol, nAzimuths, nAzimuths * dem.nrow);
+  }
+
+  // the method actually run
+  Method effectiveMethod() const {
+    return method;
+  }
+
+  // transect samples skipped by pruning so far
+  unsigned long long skippedSteps() const {
+    return skipped;
+  }
+
+  // collect the counters and busy time of every task range into stats,
+  // which must outlive the runs of the job
+  void collectStats(RunStats* runStats) {
+    stats = runStats;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    double start = stats ? stopwatch() : 0;
+    LineBuffers buffers;
+    SearchCounters counters;
+    for (std::size_t task = begin; task < end; task++) {
+      const WorkBlock& block = blocks[task];
+      int a = block.azimuth;
+      for (int unit = block.first; unit < block.last; unit++) {
+        if (method == SWEEP) {
+          sweepLine(dem, layer(a), unit, lines[a], steps[a].dxy, buffers, counters, caps[a]);
+        } else if (method == LINES) {
+          marchLine(dem, layer(a), unit, lines[a], transects[a], maxElev, prune, buffers, counters, caps[a]);
+        } else {
+          marchColumn(dem, layer(a), unit, block.rowBegin, block.rowEnd, transects[a], maxElev, pyramid.get(), counters, caps[a]);
+        }
+      }
+    }
+    skipped += counters.skipped;
+    if (stats) {
+      stats->record(counters, end - begin, stopwatch() - start);
+    }
+  }
+
+private:
+  void plan(int grainSize) {
+    blocks.clear();
+    for (std::size_t a = 0; a < steps.size(); a++) {
+      if (method == MARCH) {
+        planColumnBlocks(blocks, a, transects[a], dem.nrow, dem.ncol, grainSize, marchLanes);
+      } else {
+        // sweep is exact along each line, incFactor does not apply
+        planLineBlocks(blocks, a, lines[a], method == LINES ? &transects[a] : NULL, dem.nrow, grainSize);
+      }
+    }
+    std::stable_sort(blocks.begin(), blocks.end(), byWorkDescending);
+  }
+
+  GridView<const E> dem;
+  T* output;
+  Method method;
+  bool prune;
+  double maxElev;
+  std::shared_ptr<const MaxPyramid> pyramid;
+  std::vector<AzimuthSteps> steps;
+  std::vector<LineGeometry> lines;
+  std::vector<TransectTemplate> transects;
+  std::vector<double> caps; // tangents
+  std::vector<WorkBlock> blocks;
+  RunStats* stats;
+  mutable std::atomic<unsigned long long> skipped;
+};
+
+// number of transect steps taken per cell of a column by the serial search
+// with optional curvature correction, for profiling the search
+template <typename E>
+void countTransectSteps(
+    const GridView<const E>& dem,
+    const GridView<double>& iterationsOut,
+    int col,
+    const AzimuthSteps& steps,
+    double maxElev,
+    bool correctCurvature,
+    double incFactor
+  ) {
+  int width = dem.ncol;
+  int height = dem.nrow;
+  double dx = steps.dx;
+  double dy = steps.dy;
+  double dxy = steps.dxy;
+
+  for(int row = 0; row < height; row++) {
+    double elevationOrigin = dem(row, col);
+    double altitudeMin = 0;
+    double correction = 0;
+    int iterations = 0;
+    if (!isNA(elevationOrigin)) {
+      // calculate maximum possible difference in elevation
+      // traverse transect to find max altitude difference
+      int step = 0;
+      while (true) {
+        iterations++;
+        step = step + pow(incFactor, step + 1) ;
+        double distanceStep = dxy * step;
+        int rowStep = row + round(dy * step);
+        int colStep = col + round(dx * step);
+        if (rowStep >= 0 && rowStep < height && colStep >= 0 && colStep < width) {
+          double elevStep = dem(rowStep, colStep);
+          double elevDiffStep = elevStep - elevationOrigin;
+          if (elevDiffStep > 0) {
+            if (correctCurvature) {
+              correction = getCurvatureCorrection(distanceStep);
+              elevDiffStep = elevDiffStep - correction;
+            }
+            if (elevDiffStep > 0) {
+              // calculate angle
+              double altitudeStep = rad2deg(atan(elevDiffStep / distanceStep));
+              if (altitudeStep > altitudeMin) {
+                altitudeMin = altitudeStep;
+              } else {
+                // check if higher altitude is feasible
+                double elevationMaxDiff = maxElev - correction - elevationOrigin;
+                double altitudeMax = rad2deg(atan(elevationMaxDiff / distanceStep));
+                if (altitudeMax < altitudeMin) {
+                  break;
+                }
+              }
+            }
+          }
+        } else {
+          // break if out of bounds
+          break;
+        }
+      }
+    }
+    iterationsOut(row, col) = iterations;
+  }
+}
+
+} // namespace sunlight
+
+#endif
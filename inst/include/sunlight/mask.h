@@ -0,0 +1,168 @@
+#ifndef SUNLIGHT_MASK_H
+#define SUNLIGHT_MASK_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include "quantization.h"
+
+namespace sunlight {
+
+// shade or sunlight masks hold 1 bit per cell instead of a double: cell i of
+// a layer is bit i % 64 of word i / 64, the bits past the last cell are 0.
+// a mask of a 10000 x 10000 dem takes 12.5 MB
+
+inline std::size_t maskWords(std::size_t nCells) {
+  return (nCells + 63) / 64;
+}
+
+inline int popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(word);
+#else
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// 64 flags, each byte 0 or 1, as the bits of a word, flag k to bit k: eight
+// flags at a time are gathered into one byte by a single multiplication
+inline uint64_t packFlags(const unsigned char* flags) {
+  uint64_t word = 0;
+  for (int b = 0; b < 8; b++) {
+    uint64_t eight;
+    std::memcpy(&eight, flags + 8 * b, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    eight = __builtin_bswap64(eight);
+#endif
+    word |= ((eight * 0x0102040810204080ULL) >> 56) << (8 * b);
+  }
+  return word;
+}
+
+// the mask of nCells flags, a byte 0 or 1 per cell, for kernels that cannot
+// write bits of shared words from several threads
+inline void packMask(const unsigned char* flags, std::size_t nCells, uint64_t* words) {
+  unsigned char tail[64];
+  for (std::size_t w = 0; w < maskWords(nCells); w++) {
+    std::size_t first = w * 64;
+    if (nCells - first >= 64) {
+      words[w] = packFlags(flags + first);
+    } else {
+      std::memset(tail, 0, 64);
+      std::memcpy(tail, flags + first, nCells - first);
+      words[w] = packFlags(tail);
+    }
+  }
+}
+
+// words [beginWord, endWord) of the mask of the nCells cells at altitudes,
+// cell i at altitudes[i * cellStride]: a bit is set where the cell is shaded
+// (threshold < altitude, see HorizonType::threshold), or lit with sunlight.
+// the comparisons go to a byte per cell first, a loop without branches the
+// compiler vectorises, then are packed
+template <typename T>
+void thresholdMask(
+    const T* altitudes,
+    std::ptrdiff_t cellStride,
+    std::size_t nCells,
+    typename HorizonType<T>::threshold_type threshold,
+    bool sunlight,
+    uint64_t* words,
+    std::size_t beginWord,
+    std::size_t endWord
+  ) {
+  const unsigned char flip = sunlight ? 1 : 0;
+  unsigned char flags[64];
+  for (std::size_t w = beginWord; w < endWord; w++) {
+    std::size_t first = w * 64;
+    int n = nCells - first < 64 ? (int)(nCells - first) : 64;
+    const T* cells = altitudes + first * cellStride;
+    if (cellStride == 1 && n == 64) {
+      for (int k = 0; k < 64; k++) {
+        flags[k] = (unsigned char)(threshold < cells[k]) ^ flip;
+      }
+    } else {
+      for (int k = 0; k < n; k++) {
+        flags[k] = (unsigned char)(threshold < cells[k * cellStride]) ^ flip;
+      }
+      for (int k = n; k < 64; k++) {
+        flags[k] = 0;
+      }
+    }
+    words[w] = packFlags(flags);
+  }
+}
+
+// cells set in a mask of nWords words
+inline std::size_t countMaskCells(const uint64_t* words, std::size_t nWords) {
+  std::size_t count = 0;
+  for (std::size_t w = 0; w < nWords; w++) {
+    count += popcount64(words[w]);
+  }
+  return count;
+}
+
+// per cell count of the masks it is set in, over nMasks masks of nCells
+// cells one after the other (mask m at words[m * maskWords(nCells)]),
+// times weight into durations. each task is a word of cells: its bits across
+// the masks are added up with bit-sliced counters, one word per bit of the
+// count, so 64 cells count at once
+class MaskDurationJob {
+public:
+  MaskDurationJob(const uint64_t* words, std::size_t nMasks, std::size_t nCells, double weight, double* durations) :
+    words(words),
+    nMasks(nMasks),
+    nCells(nCells),
+    nWords(maskWords(nCells)),
+    weight(weight),
+    durations(durations) {}
+
+  std::size_t size() const {
+    return nWords;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    for (std::size_t w = begin; w < end; w++) {
+      uint64_t planes[countBits] = {0};
+      for (std::size_t m = 0; m < nMasks; m++) {
+        // ripple the word in as a carry
+        uint64_t carry = words[m * nWords + w];
+        for (int p = 0; carry != 0 && p < countBits; p++) {
+          uint64_t next = planes[p] & carry;
+          planes[p] ^= carry;
+          carry = next;
+        }
+      }
+      int used = countBits;
+      while (used > 0 && planes[used - 1] == 0) {
+        used--;
+      }
+      std::size_t first = w * 64;
+      int n = nCells - first < 64 ? (int)(nCells - first) : 64;
+      for (int k = 0; k < n; k++) {
+        unsigned long count = 0;
+        for (int p = 0; p < used; p++) {
+          count |= (unsigned long)((planes[p] >> k) & 1) << p;
+        }
+        durations[first + k] = count * weight;
+      }
+    }
+  }
+
+private:
+  static const int countBits = 32;
+
+  const uint64_t* words;
+  std::size_t nMasks;
+  std::size_t nCells;
+  std::size_t nWords;
+  double weight;
+  double* durations;
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SUNLIGHT_PARALLEL_H
+#define SUNLIGHT_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace sunlight {
+
+// runs job(begin, end) over [begin, end) in chunks of grainSize tasks that
+// the threads claim one after the other as they finish, so threads done
+// with light tasks take over the rest; for use outside R. grainSize 0 makes
+// about eight chunks per thread. inside the package the jobs run through
+// RcppParallel::parallelFor instead
+template <typename Job>
+void parallelFor(std::size_t begin, std::size_t end, const Job& job, int numThreads = -1, std::size_t grainSize = 0) {
+  if (numThreads <= 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::size_t n = end - begin;
+  if (numThreads == 1 || n <= 1) {
+    job(begin, end);
+    return;
+  }
+  if (grainSize == 0) {
+    grainSize = std::max<std::size_t>(1, n / (8 * numThreads));
+  }
+  numThreads = std::min<std::size_t>(numThreads, (n + grainSize - 1) / grainSize);
+  std::atomic<std::size_t> next(begin);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.push_back(std::thread([&job, &next, end, grainSize]() {
+      for (std::size_t start = next.fetch_add(grainSize); start < end; start = next.fetch_add(grainSize)) {
+        job(start, std::min(end, start + grainSize));
+      }
+    }));
+  }
+  for (std::size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+}
+
+} // namespace sunlight
+
+#endif
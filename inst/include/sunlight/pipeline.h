@@ -0,0 +1,123 @@
+#ifndef SUNLIGHT_PIPELINE_H
+#define SUNLIGHT_PIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "stats.h"
+
+namespace sunlight {
+
+// jobs run by background threads, in the order queued, while the thread
+// queueing them goes on: output written while the next layers compute. the
+// queue is bounded, so a producer faster than the jobs waits for a free slot
+// instead of piling up buffers. the first job that throws stops the
+// pipeline, push() and finish() then rethrow its exception. jobs must not
+// call into R
+class JobPipeline {
+public:
+  JobPipeline(int nThreads, std::size_t capacity) :
+    capacity(capacity < 1 ? 1 : capacity),
+    closed(false),
+    waited(0) {
+    if (nThreads < 1) {
+      nThreads = 1;
+    }
+    for (int t = 0; t < nThreads; t++) {
+      threads.push_back(std::thread(&JobPipeline::work, this));
+    }
+  }
+
+  // joins the threads without rethrowing, after the queued jobs or the
+  // failure
+  ~JobPipeline() {
+    close();
+  }
+
+  // queue job, waiting while the queue is full
+  void push(const std::function<void()>& job) {
+    double start = stopwatch();
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceFree.wait(lock, [this]() { return jobs.size() < capacity || error; });
+    waited += stopwatch() - start;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    jobs.push_back(job);
+    jobQueued.notify_one();
+  }
+
+  // wait for all queued jobs and stop the threads
+  void finish() {
+    close();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // seconds push() spent waiting for a free slot
+  double waitSeconds() const {
+    return waited;
+  }
+
+private:
+  void work() {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobQueued.wait(lock, [this]() { return !jobs.empty() || closed || error; });
+        if (error || jobs.empty()) {
+          return;
+        }
+        job = jobs.front();
+        jobs.pop_front();
+      }
+      spaceFree.notify_one();
+      try {
+        job();
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+        jobQueued.notify_all();
+        spaceFree.notify_all();
+      }
+    }
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+    jobQueued.notify_all();
+    for (std::size_t t = 0; t < threads.size(); t++) {
+      if (threads[t].joinable()) {
+        threads[t].join();
+      }
+    }
+  }
+
+  std::size_t capacity;
+  std::deque<std::function<void()> > jobs;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable jobQueued;
+  std::condition_variable spaceFree;
+  bool closed;
+  std::exception_ptr error;
+  double waited;
+};
+
+} // namespace sunlight
+
+#endif
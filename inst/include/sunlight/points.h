@@ -0,0 +1,123 @@
+#ifndef SUNLIGHT_POINTS_H
+#define SUNLIGHT_POINTS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "azimuth.h"
+#include "grid.h"
+#include "horizon.h"
+#include "pyramid.h"
+#include "transect.h"
+#include "util.h"
+
+namespace sunlight {
+
+// horizon profiles of a few cells of a dem, for site studies: the transect
+// of each cell is searched as march searches it, for every azimuth of a fine
+// range, without computing the horizons of the rest of the grid
+
+// a cell whose profile is computed, row -1 for points outside the dem
+struct GridPoint {
+  int row;
+  int col;
+};
+
+// points per task
+const int pointsPerTask = 64;
+
+// horizon angles in degrees of points of a dem for a list of azimuths,
+// written point-major into output, i.e. output[a + nAzimuths * i], the
+// layout of a horizon cube of the points (see AltitudeJob). points outside
+// the dem or on NA cells get NaN. tasks are one azimuth for a run of up to
+// pointsPerTask points, so any parallel loop over [0, size()) spreads both
+// points and azimuths; the transect template of an azimuth is laid out by
+// each task range that needs it. prune, correctCurvature and
+// correctRefraction as for AltitudeJob, with the same angles as its march;
+// summary, if not NULL, as for AltitudeJob too
+template <typename E>
+class PointHorizonJob {
+public:
+  PointHorizonJob(
+      const GridView<const E>& dem,
+      const std::vector<GridPoint>& points,
+      double* output,
+      const std::vector<double>& azimuths,
+      double gridConvergence,
+      double resolution,
+      double incFactor,
+      bool prune = false,
+      bool correctCurvature = false,
+      bool correctRefraction = false,
+      const DemSummary* summary = NULL
+    ) :
+    dem(dem),
+    points(points),
+    output(output),
+    incFactor(incFactor),
+    correctCurvature(correctCurvature),
+    correctRefraction(correctRefraction) {
+    maxElev = summary ? summary->maxElev : maxElevation(dem);
+    if (prune && summary && summary->pyramid) {
+      pyramid = summary->pyramid;
+    } else if (prune) {
+      pyramid.reset(new MaxPyramid(dem));
+    }
+    for (std::size_t a = 0; a < azimuths.size(); a++) {
+      steps.push_back(getAzimuthSteps(azimuths[a], gridConvergence, resolution));
+    }
+    nBlocks = (points.size() + pointsPerTask - 1) / pointsPerTask;
+  }
+
+  std::size_t size() const {
+    return steps.size() * nBlocks;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    std::size_t nAzimuths = steps.size();
+    SearchCounters counters;
+    // template of the azimuth of the previous task
+    std::unique_ptr<TransectTemplate> transect;
+    std::size_t transectAzimuth = nAzimuths;
+    for (std::size_t task = begin; task < end; task++) {
+      std::size_t a = task / nBlocks;
+      std::size_t first = (task % nBlocks) * pointsPerTask;
+      std::size_t last = std::min(points.size(), first + pointsPerTask);
+      if (a != transectAzimuth) {
+        transect.reset(new TransectTemplate(
+            steps[a], incFactor, dem.nrow, dem.ncol, dem.rowStride, dem.colStride,
+            correctCurvature, correctRefraction));
+        transectAzimuth = a;
+      }
+      for (std::size_t i = first; i < last; i++) {
+        const GridPoint& point = points[i];
+        double horizon = NAN;
+        if (point.row >= 0 && !isNA(dem(point.row, point.col))) {
+          double elevationOrigin = dem(point.row, point.col);
+          int n = transect->samples(point.row, point.col, dem.nrow, dem.ncol);
+          double best = searchTransect(dem, point.row, point.col, elevationOrigin, *transect, 0, n, 0, maxElev, pyramid.get(), counters);
+          horizon = storedHorizon<double>(best, INFINITY);
+        }
+        output[a + nAzimuths * i] = horizon;
+      }
+    }
+  }
+
+private:
+  GridView<const E> dem;
+  const std::vector<GridPoint>& points;
+  double* output;
+  double incFactor;
+  bool correctCurvature;
+  bool correctRefraction;
+  double maxElev;
+  std::shared_ptr<const MaxPyramid> pyramid;
+  std::vector<AzimuthSteps> steps;
+  std::size_t nBlocks;
+};
+
+} // namespace sunlight
+
+#endif
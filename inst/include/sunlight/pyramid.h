@@ -0,0 +1,70 @@
+#ifndef SUNLIGHT_PYRAMID_H
+#define SUNLIGHT_PYRAMID_H
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "grid.h"
+
+namespace sunlight {
+
+// max-elevation mip pyramid of a dem: level l holds the highest elevation of
+// every aligned block of 2^l x 2^l cells (NA cells ignored, -Inf for blocks
+// without data), up to the level whose single block covers the whole grid.
+// built once per dem, it bounds the terrain ahead on a transect far tighter
+// than the global maximum
+class MaxPyramid {
+public:
+  template <typename E>
+  explicit MaxPyramid(const GridView<const E>& dem) {
+    int nrow = dem.nrow;
+    int ncol = dem.ncol;
+    // level 1 from the dem itself
+    std::vector<double> previous;
+    while (nrow > 1 || ncol > 1 || maxima.empty()) {
+      int blockRows = (nrow + 1) / 2;
+      int blockCols = (ncol + 1) / 2;
+      std::vector<double> level((std::size_t)blockRows * blockCols, -INFINITY);
+      for (int col = 0; col < ncol; col++) {
+        for (int row = 0; row < nrow; row++) {
+          double elevation = maxima.empty() ? (double)dem(row, col) : previous[row + (std::size_t)nrow * col];
+          double& blockMax = level[row / 2 + (std::size_t)blockRows * (col / 2)];
+          if (elevation > blockMax) {
+            blockMax = elevation;
+          }
+        }
+      }
+      nrow = blockRows;
+      ncol = blockCols;
+      nrows.push_back(nrow);
+      maxima.push_back(level);
+      previous.swap(level);
+    }
+  }
+
+  // number of levels, the last one is a single block
+  int levels() const {
+    return maxima.size();
+  }
+
+  // highest elevation of the level (>= 1) block containing cell (row, col)
+  double blockMax(int level, int row, int col) const {
+    return maxima[level - 1][(row >> level) + (std::size_t)nrows[level - 1] * (col >> level)];
+  }
+
+private:
+  std::vector<std::vector<double> > maxima;
+  std::vector<int> nrows;
+};
+
+// what the horizon kernels derive from a whole dem before searching it: its
+// highest elevation and, for pruned searches, its pyramid. a kernel given
+// one uses it instead of scanning the dem again (see DemSession)
+struct DemSummary {
+  double maxElev;
+  std::shared_ptr<const MaxPyramid> pyramid; // NULL if not built
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SUNLIGHT_QUANTIZATION_H
+#define SUNLIGHT_QUANTIZATION_H
+
+#include <cmath>
+#include <stdint.h>
+
+namespace sunlight {
+
+// horizon angles span 0-90 degrees and can be stored as fixed-point counts:
+//   uint16_t: 0.01 degree per count (0-9000)
+//   uint8_t:  0.5 degree per count (0-180), for coarse runs
+// counts are rounded to the nearest step. HorizonType<T> describes the
+// storage type T of an altitude layer, double being unquantized degrees
+
+template <typename T> struct HorizonType;
+
+template <> struct HorizonType<double> {
+  typedef double threshold_type;
+  static const char* name() { return "none"; }
+  static double scale() { return 1; }
+  static double quantize(double altitude) { return altitude; }
+  // cell is shaded if minAltitude < altitude
+  static double threshold(double minAltitude) { return minAltitude; }
+  // horizons above this shade the cell for every sun up to minAltitude
+  static double shadedAbove(double minAltitude) { return minAltitude; }
+};
+
+template <typename T> struct QuantizedHorizonType {
+  typedef int threshold_type;
+  static T quantize(double altitude) {
+    return (T)std::floor(altitude / HorizonType<T>::scale() + 0.5);
+  }
+  // counts are integers, so minAltitude < count * scale holds exactly when
+  // count > floor(minAltitude / scale)
+  static int threshold(double minAltitude) {
+    double counts = std::floor(minAltitude / HorizonType<T>::scale());
+    if (counts < -1) {
+      return -1;
+    }
+    if (counts > 65535) {
+      return 65535;
+    }
+    return (int)counts;
+  }
+  // horizons above this round to a count beyond threshold(minAltitude), so
+  // they shade the cell for every sun up to minAltitude
+  static double shadedAbove(double minAltitude) {
+    return (threshold(minAltitude) + 0.5) * HorizonType<T>::scale();
+  }
+};
+
+template <> struct HorizonType<uint16_t> : public QuantizedHorizonType<uint16_t> {
+  static const char* name() { return "uint16"; }
+  static double scale() { return 0.01; }
+};
+
+template <> struct HorizonType<uint8_t> : public QuantizedHorizonType<uint8_t> {
+  static const char* name() { return "uint8"; }
+  static double scale() { return 0.5; }
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SUNLIGHT_RANGES_H
+#define SUNLIGHT_RANGES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "quantization.h"
+
+namespace sunlight {
+
+// horizon ranges summarise altitude layers per square tile of cells: the
+// lowest and highest stored horizon of each tile and layer. a sun above the
+// highest horizon of a tile lights all of it, one below the lowest shades
+// all of it, so threshold and duration kernels only look at the cells of
+// tiles the sun is inside the range of. around midday that is most of the
+// grid
+
+// tile size of the ranges the altitude kernels emit
+const int rangeTileSize = 64;
+
+// ranges of nLayers layers of an nrow x ncol grid in tiles of tileSize
+// cells, stored as the layers are: the range of layer l of tile (tileRow,
+// tileCol) is at index l + nLayers * (tileRow + tileRows * tileCol). the
+// lowest horizon of a tile holding NA cells is NA, as those are lit
+template <typename T>
+struct HorizonRanges {
+  typedef typename HorizonType<T>::threshold_type threshold_type;
+
+  int nrow;
+  int ncol;
+  int nLayers;
+  int tileSize;
+  int tileRows;
+  int tileCols;
+  std::vector<T> mins;
+  std::vector<T> maxs;
+
+  HorizonRanges(int nrow, int ncol, int nLayers, int tileSize = rangeTileSize) :
+    nrow(nrow),
+    ncol(ncol),
+    nLayers(nLayers),
+    tileSize(tileSize),
+    tileRows((nrow + tileSize - 1) / tileSize),
+    tileCols((ncol + tileSize - 1) / tileSize),
+    mins((std::size_t)nLayers * tileRows * tileCols),
+    maxs((std::size_t)nLayers * tileRows * tileCols) {}
+
+  // index of the range of layer of the tile holding cell i, column-major
+  std::size_t index(std::size_t i, int layer) const {
+    int row = i % nrow;
+    int col = i / nrow;
+    return layer + (std::size_t)nLayers * (row / tileSize + (std::size_t)tileRows * (col / tileSize));
+  }
+
+  // end of the run of cells from i, before last, in the same tile column
+  // segment, i.e. the same column and tile
+  std::size_t runEnd(std::size_t i, std::size_t last) const {
+    int row = i % nrow;
+    std::size_t end = i + std::min(nrow - row, tileSize - row % tileSize);
+    return std::min(end, last);
+  }
+
+  // shade (1) of every cell of the tile at index for a sun at threshold, 0
+  // if none is shaded, -1 if the tile is mixed (see HorizonType::threshold)
+  int shade(std::size_t index, threshold_type threshold) const {
+    if (threshold < mins[index]) {
+      return 1;
+    }
+    return threshold < maxs[index] ? -1 : 0;
+  }
+};
+
+// bound of a range of T without a value: NA where T has it, else the count
+// of a horizon of 0, as the altitude kernels store for NA cells of the dem
+template <typename T>
+T noRangeBound() {
+  return std::numeric_limits<T>::has_quiet_NaN ? std::numeric_limits<T>::quiet_NaN() : HorizonType<T>::quantize(0);
+}
+
+// ranges of altitude layers, layer l of cell i at altitudes[l * layerStride
+// + i * cellStride] as for DurationJob. a task is a column of tiles
+template <typename T>
+class HorizonRangeJob {
+public:
+  HorizonRangeJob(
+      const T* altitudes,
+      std::ptrdiff_t layerStride,
+      std::ptrdiff_t cellStride,
+      HorizonRanges<T>& ranges
+    ) :
+    altitudes(altitudes),
+    layerStride(layerStride),
+    cellStride(cellStride),
+    ranges(ranges) {}
+
+  std::size_t size() const {
+    return ranges.tileCols;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    int nLayers = ranges.nLayers;
+    std::size_t nRanges = (std::size_t)nLayers * ranges.tileRows;
+    // in doubles, counts of quantized layers fit exactly
+    std::vector<double> lows(nRanges), highs(nRanges);
+    std::vector<unsigned char> withNA(nRanges);
+    for (std::size_t tileCol = begin; tileCol < end; tileCol++) {
+      std::fill(lows.begin(), lows.end(), INFINITY);
+      std::fill(highs.begin(), highs.end(), -INFINITY);
+      std::fill(withNA.begin(), withNA.end(), 0);
+      int firstCol = tileCol * ranges.tileSize;
+      int lastCol = std::min(ranges.ncol, firstCol + ranges.tileSize);
+      for (int col = firstCol; col < lastCol; col++) {
+        for (int row = 0; row < ranges.nrow; row++) {
+          const T* cell = altitudes + (row + (std::size_t)ranges.nrow * col) * cellStride;
+          std::size_t base = (std::size_t)nLayers * (row / ranges.tileSize);
+          for (int l = 0; l < nLayers; l++) {
+            double value = cell[l * layerStride];
+            if (value != value) {
+              withNA[base + l] = 1;
+              continue;
+            }
+            lows[base + l] = std::min(lows[base + l], value);
+            highs[base + l] = std::max(highs[base + l], value);
+          }
+        }
+      }
+      std::size_t offset = nRanges * tileCol;
+      for (std::size_t k = 0; k < nRanges; k++) {
+        // tiles of NA cells only: no bound either, all lit
+        ranges.mins[offset + k] = withNA[k] || lows[k] > highs[k] ? noRangeBound<T>() : (T)lows[k];
+        ranges.maxs[offset + k] = lows[k] > highs[k] ? noRangeBound<T>() : (T)highs[k];
+      }
+    }
+  }
+
+private:
+  const T* altitudes;
+  std::ptrdiff_t layerStride;
+  std::ptrdiff_t cellStride;
+  HorizonRanges<T>& ranges;
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SUNLIGHT_SCHEDULE_H
+#define SUNLIGHT_SCHEDULE_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "azimuth.h"
+#include "transect.h"
+
+namespace sunlight {
+
+// the work of a horizon run is far from uniform: a cell near the edge the
+// sun shines from has a transect of a few samples, one at the far edge runs
+// across the whole dem. whole columns or lines as tasks leave a few threads
+// with most of the work, so the runs are cut into blocks of about grainSize
+// cells, each with an estimate of its work from the transect lengths of its
+// cells, and handed out heaviest first: with dynamic scheduling or work
+// stealing, the tail of a run is then made of the lightest blocks
+
+// cells per block unless given
+const int defaultGrainSize = 4096;
+
+// a block of one azimuth: columns [first, last) x rows [rowBegin, rowEnd)
+// for march, lines [first, last) for lines and sweep
+struct WorkBlock {
+  int azimuth;
+  int first;
+  int last;
+  int rowBegin;
+  int rowEnd;
+  double work; // estimated, in transect samples
+};
+
+inline bool byWorkDescending(const WorkBlock& a, const WorkBlock& b) {
+  return a.work > b.work;
+}
+
+// square blocks of about grainSize cells, whole groups of lanes high
+// (rowMultiple, see marchLanes), estimated by the transect of their centre
+inline void planColumnBlocks(
+    std::vector<WorkBlock>& blocks,
+    int azimuth,
+    const TransectTemplate& transect,
+    int nrow,
+    int ncol,
+    int grainSize,
+    int rowMultiple
+  ) {
+  int blockRows = (int)std::sqrt((double)grainSize) / rowMultiple * rowMultiple;
+  blockRows = std::max(rowMultiple, blockRows);
+  int blockCols = std::max(1, grainSize / blockRows);
+  for (int col = 0; col < ncol; col += blockCols) {
+    for (int row = 0; row < nrow; row += blockRows) {
+      WorkBlock block = {azimuth, col, std::min(ncol, col + blockCols), row, std::min(nrow, row + blockRows), 0};
+      int centreRow = (block.rowBegin + block.rowEnd - 1) / 2;
+      int centreCol = (block.first + block.last - 1) / 2;
+      double cells = (double)(block.rowEnd - block.rowBegin) * (block.last - block.first);
+      block.work = cells * (1 + transect.samples(centreRow, centreCol, nrow, ncol));
+      blocks.push_back(block);
+    }
+  }
+}
+
+// runs of consecutive lines of about grainSize cells. a cell i steps into a
+// line of n cells has the samples of transect closer than n - i steps, none
+// for a sweep (transect NULL), which visits each cell once
+inline void planLineBlocks(
+    std::vector<WorkBlock>& blocks,
+    int azimuth,
+    const LineGeometry& lines,
+    const TransectTemplate* transect,
+    int nrow,
+    int grainSize
+  ) {
+  // work of a whole line of n cells
+  std::vector<double> lineWork(lines.nMajor + 1, 0);
+  int k = 0;
+  for (int n = 1; n <= lines.nMajor; n++) {
+    while (transect && k < transect->size() && transect->stepFactors[k] < n) {
+      k++;
+    }
+    lineWork[n] = lineWork[n - 1] + 1 + k;
+  }
+  WorkBlock block = {azimuth, 0, 0, 0, nrow, 0};
+  int cells = 0;
+  for (int line = 0; line < lines.nLines; line++) {
+    int n = lines.length(line);
+    cells += n;
+    block.work += lineWork[n];
+    block.last = line + 1;
+    if (cells >= grainSize || line == lines.nLines - 1) {
+      blocks.push_back(block);
+      block.first = block.last;
+      block.work = 0;
+      cells = 0;
+    }
+  }
+}
+
+} // namespace sunlight
+
+#endif
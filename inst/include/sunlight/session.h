@@ -0,0 +1,49 @@
+#ifndef SUNLIGHT_SESSION_H
+#define SUNLIGHT_SESSION_H
+
+#include <cstddef>
+#include <vector>
+#include "grid.h"
+#include "pyramid.h"
+
+namespace sunlight {
+
+// a dem loaded once for many kernel runs, per azimuth, time or point: it
+// owns a column-major copy of the elevations and its summary (see
+// DemSummary), the pyramid built the first time a pruned run asks for it.
+// runs only read it; prepare() must not run concurrently with itself
+class DemSession {
+public:
+  DemSession(const double* elevations, int nrow, int ncol) :
+    elevations(elevations, elevations + (std::size_t)nrow * ncol),
+    nrow(nrow),
+    ncol(ncol) {
+    summary.maxElev = maxElevation(view());
+  }
+
+  GridView<const double> view() const {
+    return GridView<const double>(elevations.data(), nrow, ncol);
+  }
+
+  // the summary, with the pyramid built first if withPyramid
+  const DemSummary& prepare(bool withPyramid) {
+    if (withPyramid && !summary.pyramid) {
+      summary.pyramid.reset(new MaxPyramid(view()));
+    }
+    return summary;
+  }
+
+  const DemSummary& getSummary() const {
+    return summary;
+  }
+
+private:
+  std::vector<double> elevations;
+  int nrow;
+  int ncol;
+  DemSummary summary;
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SUNLIGHT_SHADOW_H
+#define SUNLIGHT_SHADOW_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "azimuth.h"
+#include "grid.h"
+#include "schedule.h"
+#include "util.h"
+
+namespace sunlight {
+
+// shades of a dem for a single sun position without any horizon: walking
+// each line of the sun's azimuth from the sun side, the shadow surface cast
+// by the terrain seen so far sinks by the sun's tangent per unit of
+// distance, so it is carried along as the one point casting it highest. a
+// cell below it is shaded, a cell above it casts the surface from then on.
+// one pass over the cells, at the exact azimuth instead of the nearest layer
+// of a cube
+
+// shade (1) or, with sunlight, sunlight (1) of the cells of one line of
+// lines, for a sun whose altitude has tangent tangent, dxy the distance of a
+// step along the line. a cell is shaded where its horizon along the line
+// (see sweepLine) is above the sun, the same cells as thresholding the
+// horizons of a sweep. NA cells have a horizon of 0, as in the horizon
+// kernels, and cast no shadow
+template <typename E, typename O>
+void castLineShadow(
+    const GridView<const E>& dem,
+    const GridView<O>& output,
+    int line,
+    const LineGeometry& lines,
+    double dxy,
+    double tangent,
+    bool sunlight
+  ) {
+  const int flip = sunlight ? 1 : 0;
+  // the point casting the shadow surface, none yet
+  int castT = 0;
+  double castZ = -INFINITY;
+  for (int t = lines.nMajor - 1; t >= 0; t--) {
+    int row, col;
+    if (!lines.cell(line, t, row, col)) {
+      continue;
+    }
+    double elevation = dem(row, col);
+    int shaded = 0;
+    if (isNA(elevation)) {
+      shaded = tangent < 0;
+    } else {
+      double surface = castZ - tangent * dxy * (castT - t);
+      shaded = elevation < surface || tangent < 0;
+      if (!(elevation < surface)) {
+        castT = t;
+        castZ = elevation;
+      }
+    }
+    output(row, col) = (O)(shaded ^ flip);
+  }
+}
+
+// castLineShadow over a whole dem for a sun at azimuth and altitude in
+// degrees, into output (0/1 per cell, of type O, laid out as the dem). tasks
+// are runs of lines of about defaultGrainSize cells (see planLineBlocks);
+// every cell is on one line only, so task ranges write disjoint cells
+template <typename E, typename O>
+class ShadowJob {
+public:
+  ShadowJob(
+      const GridView<const E>& dem,
+      const GridView<O>& output,
+      double azimuth,
+      double altitude,
+      double gridConvergence,
+      double resolution,
+      bool sunlight = false
+    ) :
+    dem(dem),
+    output(output),
+    steps(getAzimuthSteps(azimuth, gridConvergence, resolution)),
+    lines(steps.dx, steps.dy, dem.nrow, dem.ncol),
+    sunlight(sunlight) {
+    // the sun at 90 casts no shadow; below 0 it shades everything, as it
+    // is below the horizon of every cell
+    tangent = altitude >= 90 ? INFINITY : tan(deg2rad(altitude));
+    planLineBlocks(blocks, 0, lines, NULL, dem.nrow, defaultGrainSize);
+  }
+
+  std::size_t size() const {
+    return blocks.size();
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    for (std::size_t task = begin; task < end; task++) {
+      for (int line = blocks[task].first; line < blocks[task].last; line++) {
+        castLineShadow(dem, output, line, lines, steps.dxy, tangent, sunlight);
+      }
+    }
+  }
+
+private:
+  GridView<const E> dem;
+  GridView<O> output;
+  AzimuthSteps steps;
+  LineGeometry lines;
+  double tangent;
+  bool sunlight;
+  std::vector<WorkBlock> blocks;
+};
+
+} // namespace sunlight
+
+#endif
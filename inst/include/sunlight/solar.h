@@ -0,0 +1,228 @@
+#ifndef SUNLIGHT_SOLAR_H
+#define SUNLIGHT_SOLAR_H
+
+#include <algorithm>
+#include <cmath>
+#include "util.h"
+
+namespace sunlight {
+
+// solar position after the NOAA solar calculator (Meeus), accurate to about
+// 0.01 degree for years 1800-2100. times are UTC seconds since 1970 (R's
+// POSIXct), lat/lon in degrees, east positive. azimuths follow the altitude
+// kernels: degrees clockwise from north
+
+// altitude of the sun's centre at sunrise and sunset: the upper limb on the
+// horizon, with standard refraction
+const double sunriseAltitude = -0.833;
+
+struct SunPosition {
+  double azimuth;
+  double altitude;
+};
+
+// declination (degrees) and equation of time (minutes) of the sun at time
+struct SolarParameters {
+  double declination;
+  double equationOfTime;
+};
+
+inline SolarParameters getSolarParameters(double time) {
+  double julianDay = time / 86400 + 2440587.5;
+  double century = (julianDay - 2451545) / 36525;
+  double meanLongitude = dmod(280.46646 + century * (36000.76983 + century * 0.0003032), 360);
+  double meanAnomaly = 357.52911 + century * (35999.05029 - 0.0001537 * century);
+  double eccentricity = 0.016708634 - century * (0.000042037 + 0.0000001267 * century);
+  double anomaly = deg2rad(meanAnomaly);
+  double equationOfCentre =
+    sin(anomaly) * (1.914602 - century * (0.004817 + 0.000014 * century)) +
+    sin(2 * anomaly) * (0.019993 - 0.000101 * century) +
+    sin(3 * anomaly) * 0.000289;
+  double omega = deg2rad(125.04 - 1934.136 * century);
+  double apparentLongitude = meanLongitude + equationOfCentre - 0.00569 - 0.00478 * sin(omega);
+  double meanObliquity = 23 + (26 + (21.448 - century * (46.815 + century * (0.00059 - century * 0.001813))) / 60) / 60;
+  double obliquity = deg2rad(meanObliquity + 0.00256 * cos(omega));
+
+  SolarParameters parameters;
+  parameters.declination = rad2deg(asin(sin(obliquity) * sin(deg2rad(apparentLongitude))));
+  double y = pow(tan(obliquity / 2), 2);
+  double longitude = deg2rad(meanLongitude);
+  parameters.equationOfTime = 4 * rad2deg(
+    y * sin(2 * longitude) -
+    2 * eccentricity * sin(anomaly) +
+    4 * eccentricity * y * sin(anomaly) * cos(2 * longitude) -
+    0.5 * y * y * sin(4 * longitude) -
+    1.25 * eccentricity * eccentricity * sin(2 * anomaly)
+  );
+  return parameters;
+}
+
+// acos clamped against rounding just outside [-1, 1]
+inline double clampedAcos(double x) {
+  return acos(x < -1 ? -1 : (x > 1 ? 1 : x));
+}
+
+// apparent raise of the sun by atmospheric refraction at altitude (degrees)
+inline double getAtmosphericRefraction(double altitude) {
+  if (altitude > 85) {
+    return 0;
+  }
+  double t = tan(deg2rad(altitude));
+  double seconds;
+  if (altitude > 5) {
+    seconds = 58.1 / t - 0.07 / pow(t, 3) + 0.000086 / pow(t, 5);
+  } else if (altitude > -0.575) {
+    seconds = 1735 + altitude * (-518.2 + altitude * (103.4 + altitude * (-12.79 + altitude * 0.711)));
+  } else {
+    seconds = -20.772 / t;
+  }
+  return seconds / 3600;
+}
+
+// geometric position of the sun's centre, or apparent with correctRefraction
+inline SunPosition getSunPosition(double time, double lat, double lon, bool correctRefraction = false) {
+  SolarParameters parameters = getSolarParameters(time);
+  double minutes = time / 60 - 1440 * floor(time / 86400);
+  double trueSolarTime = dmod(minutes + parameters.equationOfTime + 4 * lon, 1440);
+  if (trueSolarTime < 0) {
+    trueSolarTime += 1440;
+  }
+  double hourAngle = trueSolarTime / 4 - 180;
+  double phi = deg2rad(lat);
+  double delta = deg2rad(parameters.declination);
+  double zenith = clampedAcos(sin(phi) * sin(delta) + cos(phi) * cos(delta) * cos(deg2rad(hourAngle)));
+
+  SunPosition position;
+  position.altitude = 90 - rad2deg(zenith);
+  double denominator = cos(phi) * sin(zenith);
+  double azimuth = 0;
+  if (std::fabs(denominator) > 1e-12) {
+    azimuth = rad2deg(clampedAcos((sin(phi) * cos(zenith) - sin(delta)) / denominator));
+  }
+  position.azimuth = hourAngle > 0 ? dmod(azimuth + 180, 360) : dmod(540 - azimuth, 360);
+  if (correctRefraction) {
+    position.altitude += getAtmosphericRefraction(position.altitude);
+  }
+  return position;
+}
+
+// the sun's declination stays within the obliquity of the ecliptic, 23.44
+// degrees, rounded up here for a safe envelope
+const double maxDeclination = 23.45;
+
+// highest geometric altitude (degrees) of the sun's centre in azimuth over
+// any year at latitude lat, -90 if the sun never shows there. every day the
+// sun passes all sky points of its declination, so over a year it covers the
+// band of declinations within maxDeclination: the highest point of the band
+// in azimuth is the zenith if inside, else a point on the band's edge
+inline double getMaxSunAltitudeAt(double azimuth, double lat) {
+  double band = sin(deg2rad(maxDeclination));
+  double phi = deg2rad(lat);
+  // sine of the declination of the sky point at altitude h: a sin h + b cos h
+  double a = sin(phi);
+  double b = cos(phi) * cos(deg2rad(azimuth));
+  if (std::fabs(a) <= band) {
+    return 90;
+  }
+  double r = sqrt(a * a + b * b);
+  double theta = atan2(b, a);
+  double best = -M_PI / 2;
+  for (int sign = -1; sign <= 1; sign += 2) {
+    double x = sign * band / r;
+    if (x < -1 || x > 1) {
+      continue;
+    }
+    double roots[2] = {asin(x), M_PI - asin(x)};
+    for (int k = 0; k < 2; k++) {
+      double h = roots[k] - theta;
+      h -= 2 * M_PI * floor((h + M_PI) / (2 * M_PI));
+      if (h >= -M_PI / 2 && h <= M_PI / 2 && h > best) {
+        best = h;
+      }
+    }
+  }
+  return rad2deg(best);
+}
+
+// highest altitude of the sun in azimuths within halfWidth of azimuth, e.g.
+// the bin of a horizon layer, sampled every 0.01 degree; apparent with
+// correctRefraction. the envelope may peak between two samples, so the
+// largest change between neighbouring samples is added as a margin: a cap
+// may be a little high, which only costs searching, never low, which would
+// mark sunlit cells never sunlit
+inline double getMaxSunAltitude(double azimuth, double lat, double halfWidth = 0, bool correctRefraction = false) {
+  int n = std::ceil(2 * halfWidth / 0.01);
+  double best = -90;
+  double margin = 0;
+  double previous = 0;
+  for (int i = 0; i <= n; i++) {
+    double offset = n > 0 ? -halfWidth + 2 * halfWidth * i / n : 0;
+    double altitude = getMaxSunAltitudeAt(azimuth + offset, lat);
+    // the sun only shows on one side of a step into -90
+    if (i > 0 && altitude > -90 && previous > -90) {
+      margin = std::max(margin, std::fabs(altitude - previous));
+    }
+    best = std::max(best, altitude);
+    previous = altitude;
+  }
+  if (best > -90) {
+    best = std::min(90.0, best + margin);
+  }
+  if (correctRefraction && best > -90) {
+    best = std::min(90.0, best + getAtmosphericRefraction(best));
+  }
+  return best;
+}
+
+// sunrise, solar noon and sunset (UTC seconds) of the UTC day starting at
+// dayStart. polar day and night have no sunrise or sunset: both are NaN and
+// polar tells which of the two it is (1 day, -1 night, 0 otherwise)
+struct SunlightTimes {
+  double sunrise;
+  double noon;
+  double sunset;
+  int polar;
+};
+
+inline SunlightTimes getSunlightTimes(double dayStart, double lat, double lon) {
+  SunlightTimes times;
+  // solar noon, refined with the parameters at the previous estimate
+  double noon = dayStart + (720 - 4 * lon) * 60;
+  for (int i = 0; i < 2; i++) {
+    noon = dayStart + (720 - 4 * lon - getSolarParameters(noon).equationOfTime) * 60;
+  }
+  times.noon = noon;
+  times.polar = 0;
+  double phi = deg2rad(lat);
+  // sunrise and sunset from the day arc at noon, each refined with the
+  // parameters at its previous estimate
+  double events[2];
+  for (int e = 0; e < 2; e++) {
+    int sign = e == 0 ? -1 : 1;
+    double event = noon;
+    for (int i = 0; i < 3; i++) {
+      SolarParameters parameters = getSolarParameters(event);
+      double delta = deg2rad(parameters.declination);
+      double cosHourAngle = (sin(deg2rad(sunriseAltitude)) - sin(phi) * sin(delta)) / (cos(phi) * cos(delta));
+      if (cosHourAngle > 1 || cosHourAngle < -1) {
+        times.polar = cosHourAngle < -1 ? 1 : -1;
+        event = NAN;
+        break;
+      }
+      double eventNoon = dayStart + (720 - 4 * lon - parameters.equationOfTime) * 60;
+      event = eventNoon + sign * rad2deg(acos(cosHourAngle)) * 4 * 60;
+    }
+    events[e] = event;
+  }
+  times.sunrise = events[0];
+  times.sunset = events[1];
+  if (isNA(times.sunrise) || isNA(times.sunset)) {
+    times.sunrise = NAN;
+    times.sunset = NAN;
+  }
+  return times;
+}
+
+} // namespace sunlight
+
+#endif
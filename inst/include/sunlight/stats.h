@@ -0,0 +1,133 @@
+#ifndef SUNLIGHT_STATS_H
+#define SUNLIGHT_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace sunlight {
+
+// what the horizon searches of a task range did, kept by the range itself
+// and handed to RunStats once at its end. every cell searched ends either
+// early (nothing ahead can raise its horizon, or it passed its cap) or at
+// the grid edge; sweep has no transects, its steps are the hull points
+// looked at
+struct SearchCounters {
+  unsigned long long steps; // transect samples read
+  unsigned long long skipped; // transect samples skipped by pruning
+  unsigned long long earlyBreaks;
+  unsigned long long edgeExits;
+  unsigned long long naCells;
+
+  SearchCounters() :
+    steps(0),
+    skipped(0),
+    earlyBreaks(0),
+    edgeExits(0),
+    naCells(0) {}
+};
+
+// seconds since some fixed point, for phase and busy times
+inline double stopwatch() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// counters of a run collected per thread without locks: each thread adds to
+// a slot of its own, on a cache line of its own, claimed the first time it
+// records for this run. more threads than slots share slots, which only
+// merges their per-thread figures
+class RunStats {
+public:
+  struct Slot {
+    std::atomic<unsigned long long> steps;
+    std::atomic<unsigned long long> skipped;
+    std::atomic<unsigned long long> earlyBreaks;
+    std::atomic<unsigned long long> edgeExits;
+    std::atomic<unsigned long long> naCells;
+    std::atomic<unsigned long long> tasks;
+    std::atomic<unsigned long long> busyNanoseconds;
+    char padding[64 - 7 * sizeof(unsigned long long)];
+  };
+
+  explicit RunStats(int nSlots = 0) :
+    run(nextRun()++),
+    nextSlot(0) {
+    if (nSlots <= 0) {
+      nSlots = std::max(64u, 2 * std::thread::hardware_concurrency());
+    }
+    nSlotsTotal = nSlots;
+    slots.reset(new Slot[nSlots]);
+    for (int s = 0; s < nSlots; s++) {
+      slots[s].steps = 0;
+      slots[s].skipped = 0;
+      slots[s].earlyBreaks = 0;
+      slots[s].edgeExits = 0;
+      slots[s].naCells = 0;
+      slots[s].tasks = 0;
+      slots[s].busyNanoseconds = 0;
+    }
+  }
+
+  // add the counters of tasks tasks the calling thread ran in seconds
+  void record(const SearchCounters& counters, std::size_t tasks, double seconds) {
+    Slot& slot = slots[slotIndex()];
+    slot.steps.fetch_add(counters.steps, std::memory_order_relaxed);
+    slot.skipped.fetch_add(counters.skipped, std::memory_order_relaxed);
+    slot.earlyBreaks.fetch_add(counters.earlyBreaks, std::memory_order_relaxed);
+    slot.edgeExits.fetch_add(counters.edgeExits, std::memory_order_relaxed);
+    slot.naCells.fetch_add(counters.naCells, std::memory_order_relaxed);
+    slot.tasks.fetch_add(tasks, std::memory_order_relaxed);
+    slot.busyNanoseconds.fetch_add((unsigned long long)(seconds * 1e9), std::memory_order_relaxed);
+  }
+
+  // threads that recorded, the first threads() slots
+  int threads() const {
+    return std::min(nextSlot.load(), nSlotsTotal);
+  }
+
+  const Slot& slot(int s) const {
+    return slots[s];
+  }
+
+  // counters over all threads
+  SearchCounters total() const {
+    SearchCounters counters;
+    for (int s = 0; s < threads(); s++) {
+      counters.steps += slots[s].steps;
+      counters.skipped += slots[s].skipped;
+      counters.earlyBreaks += slots[s].earlyBreaks;
+      counters.edgeExits += slots[s].edgeExits;
+      counters.naCells += slots[s].naCells;
+    }
+    return counters;
+  }
+
+private:
+  static std::atomic<unsigned long long>& nextRun() {
+    static std::atomic<unsigned long long> counter(0);
+    return counter;
+  }
+
+  int slotIndex() {
+    // the run and slot this thread last recorded to
+    static thread_local unsigned long long threadRun = ~0ULL;
+    static thread_local int threadSlot = 0;
+    if (threadRun != run) {
+      threadRun = run;
+      threadSlot = nextSlot.fetch_add(1) % nSlotsTotal;
+    }
+    return threadSlot;
+  }
+
+  unsigned long long run;
+  std::atomic<int> nextSlot;
+  int nSlotsTotal;
+  std::unique_ptr<Slot[]> slots;
+};
+
+} // namespace sunlight
+
+#endif
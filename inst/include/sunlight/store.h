@@ -0,0 +1,376 @@
+#ifndef SUNLIGHT_STORE_H
+#define SUNLIGHT_STORE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "duration.h"
+#include "grid.h"
+#include "quantization.h"
+#include "solar.h"
+#include "util.h"
+
+namespace sunlight {
+
+// a horizon store is a binary file holding the horizon cube of a dem for a
+// regular range of azimuths, cell-major: all azimuths of a cell are adjacent,
+// cells in column-major order, i.e. the (azimuth, row, col) layout of
+// AltitudeJob. a point query reads one cell, so the file is memory-mapped and
+// only the pages touched are ever read. the header is followed by the cube at
+// dataOffset, in native byte order. a store of a capped run (see AltitudeJob)
+// has the caps after the cube, a double per azimuth, and one of a run with
+// far fields the reach of that run, so updates keep both. stores of version
+// 1 have neither
+
+const char storeMagic[8] = {'S', 'L', 'H', 'O', 'R', 'I', 'Z', '2'};
+const char storeMagicVersion1[8] = {'S', 'L', 'H', 'O', 'R', 'I', 'Z', '1'};
+
+// flags of a store
+const uint32_t storeCapped = 1; // the caps follow the cube
+
+struct StoreHeader {
+  char magic[8];
+  int32_t type; // 0 double degrees, 1 uint16 counts, 2 uint8 counts
+  int32_t nAzimuths;
+  int32_t nrow;
+  int32_t ncol;
+  double azimuthMin;
+  double azimuthStep;
+  double scale; // degrees per stored unit
+  // georeference of the grid: left and top edge, cell width and height
+  double xmin;
+  double ymax;
+  double xres;
+  double yres;
+  uint64_t dataOffset;
+  uint32_t flags; // from version 2
+  uint32_t reserved;
+  // reach of the dem's transects of a run with far fields (see
+  // FarFieldJob), 0 without
+  double farReach;
+};
+
+// size of the header of a version 1 store, up to dataOffset
+const std::size_t storeHeaderSizeVersion1 = offsetof(StoreHeader, flags);
+
+template <typename T> struct StoreType;
+template <> struct StoreType<double> { static int32_t id() { return 0; } };
+template <> struct StoreType<uint16_t> { static int32_t id() { return 1; } };
+template <> struct StoreType<uint8_t> { static int32_t id() { return 2; } };
+
+inline std::size_t storeValueSize(int32_t type) {
+  return type == 0 ? sizeof(double) : (type == 1 ? sizeof(uint16_t) : sizeof(uint8_t));
+}
+
+// the whole of a file mapped into memory, read-only or writable. creating a
+// file sizes it first, so the mapping can be written through right away
+class MappedFile {
+public:
+  MappedFile(const std::string& path, bool writable, std::size_t createSize = 0) :
+    data(NULL),
+    length(0) {
+#ifdef _WIN32
+    DWORD access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    DWORD disposition = createSize > 0 ? CREATE_ALWAYS : OPEN_EXISTING;
+    file = CreateFileA(path.c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    LARGE_INTEGER size;
+    if (createSize > 0) {
+      size.QuadPart = createSize;
+    } else if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      throw std::runtime_error("cannot read the size of " + path);
+    }
+    length = size.QuadPart;
+    mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, size.HighPart, size.LowPart, NULL);
+    if (mapping == NULL) {
+      CloseHandle(file);
+      throw std::runtime_error("cannot map " + path);
+    }
+    data = (char*)MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      throw std::runtime_error("cannot map " + path);
+    }
+#else
+    int flags = writable ? O_RDWR : O_RDONLY;
+    if (createSize > 0) {
+      flags |= O_CREAT | O_TRUNC;
+    }
+    descriptor = open(path.c_str(), flags, 0644);
+    if (descriptor < 0) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    if (createSize > 0) {
+      if (ftruncate(descriptor, createSize) != 0) {
+        close(descriptor);
+        throw std::runtime_error("cannot size " + path);
+      }
+      length = createSize;
+    } else {
+      struct stat status;
+      if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        throw std::runtime_error("cannot read the size of " + path);
+      }
+      length = status.st_size;
+    }
+    void* mapped = mmap(NULL, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+    if (mapped == MAP_FAILED) {
+      close(descriptor);
+      throw std::runtime_error("cannot map " + path);
+    }
+    data = (char*)mapped;
+#endif
+  }
+
+  ~MappedFile() {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    munmap(data, length);
+    close(descriptor);
+#endif
+  }
+
+  char* begin() const {
+    return data;
+  }
+
+  std::size_t size() const {
+    return length;
+  }
+
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  char* data;
+  std::size_t length;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int descriptor;
+#endif
+};
+
+// a mapped horizon store, opened for queries or created to be filled
+class HorizonStore {
+public:
+  // open an existing store, read-only or to fill in parts of the cube
+  explicit HorizonStore(const std::string& path, bool writable = false) :
+    file(path, writable) {
+    if (file.size() < storeHeaderSizeVersion1) {
+      throw std::runtime_error("not a horizon store: " + path);
+    }
+    header = StoreHeader();
+    if (std::memcmp(file.begin(), storeMagicVersion1, sizeof(storeMagic)) == 0) {
+      std::memcpy(&header, file.begin(), storeHeaderSizeVersion1);
+    } else {
+      if (file.size() < sizeof(StoreHeader)) {
+        throw std::runtime_error("not a horizon store: " + path);
+      }
+      std::memcpy(&header, file.begin(), sizeof(StoreHeader));
+      if (std::memcmp(header.magic, storeMagic, sizeof(storeMagic)) != 0) {
+        throw std::runtime_error("not a horizon store: " + path);
+      }
+    }
+    if (header.type < 0 || header.type > 2 || header.dataOffset + cubeSize(header) + capsSize(header) > file.size()) {
+      throw std::runtime_error("not a horizon store: " + path);
+    }
+  }
+
+  // create a store for header, whose magic, dataOffset and flags are filled
+  // in, with the caps of the run if not empty
+  HorizonStore(const std::string& path, StoreHeader newHeader, const std::vector<double>& altitudeCaps = std::vector<double>()) :
+    file(path, true, sizeof(StoreHeader) + cubeSize(newHeader) + altitudeCaps.size() * sizeof(double)) {
+    if (!altitudeCaps.empty() && altitudeCaps.size() != (std::size_t)newHeader.nAzimuths) {
+      throw std::invalid_argument("altitudeCaps must have one cap per azimuth");
+    }
+    header = newHeader;
+    std::memcpy(header.magic, storeMagic, sizeof(storeMagic));
+    header.dataOffset = sizeof(StoreHeader);
+    header.flags = altitudeCaps.empty() ? 0 : storeCapped;
+    std::memcpy(file.begin(), &header, sizeof(StoreHeader));
+    if (!altitudeCaps.empty()) {
+      std::memcpy(file.begin() + header.dataOffset + cubeSize(header), &altitudeCaps[0], capsSize(header));
+    }
+  }
+
+  const StoreHeader& getHeader() const {
+    return header;
+  }
+
+  // the cube, valid as long as the store is open; T must match header.type
+  template <typename T>
+  T* data() const {
+    if (StoreType<T>::id() != header.type) {
+      throw std::runtime_error("horizon store type mismatch");
+    }
+    return reinterpret_cast<T*>(file.begin() + header.dataOffset);
+  }
+
+  // the caps the store was written with, degrees per azimuth, or empty
+  std::vector<double> altitudeCaps() const {
+    std::vector<double> caps(capsSize(header) / sizeof(double));
+    if (!caps.empty()) {
+      std::memcpy(&caps[0], file.begin() + header.dataOffset + cubeSize(header), capsSize(header));
+    }
+    return caps;
+  }
+
+  // row and column of the cell containing (x, y), false outside the grid
+  bool cellAt(double x, double y, int& row, int& col) const {
+    return gridCellAt(x, y, header.xmin, header.ymax, header.xres, header.yres, header.nrow, header.ncol, row, col);
+  }
+
+private:
+  static std::size_t capsSize(const StoreHeader& header) {
+    return header.flags & storeCapped ? header.nAzimuths * sizeof(double) : 0;
+  }
+
+  static std::size_t cubeSize(const StoreHeader& header) {
+    return (std::size_t)header.nAzimuths * header.nrow * header.ncol * storeValueSize(header.type);
+  }
+
+  MappedFile file;
+  StoreHeader header;
+};
+
+// a point queried in a store: its cell, row -1 outside the grid, and the
+// location lat/lon the sun is computed for
+struct StorePoint {
+  int row;
+  int col;
+  double lat;
+  double lon;
+};
+
+// shades or sunlight of points at a list of times, one task per point. the
+// horizons of a point are one contiguous run of the store, so each time
+// reads a single value next to the previous ones. the sun at each time goes
+// to the nearest azimuth of the store (see getAzimuthLayer).
+//   shades, if not NULL, gets 1 (shaded) or 0 for point i and time j at
+//   [i + nPoints * j], unknown for points outside the grid and azimuths
+//   outside the store
+//   durations, if not NULL, gets per point the weight of the daylight times
+//   in which it is lit, NaN outside the grid; azimuths outside the store add
+//   nothing, as for getSunSamples
+template <typename T>
+class PointQueryJob {
+public:
+  PointQueryJob(
+      const HorizonStore& store,
+      const std::vector<StorePoint>& points,
+      const std::vector<double>& times,
+      bool correctRefraction,
+      int* shades,
+      int unknown,
+      double* durations,
+      double weight
+    ) :
+    PointQueryJob(store.getHeader(), store.data<T>(), points, times, correctRefraction, shades, unknown, durations, weight) {}
+
+  // the same on a cube in memory laid out as a store with header
+  PointQueryJob(
+      const StoreHeader& header,
+      const T* cube,
+      const std::vector<StorePoint>& points,
+      const std::vector<double>& times,
+      bool correctRefraction,
+      int* shades,
+      int unknown,
+      double* durations,
+      double weight
+    ) :
+    header(header),
+    cube(cube),
+    points(points),
+    times(times),
+    correctRefraction(correctRefraction),
+    shades(shades),
+    unknown(unknown),
+    durations(durations),
+    weight(weight) {}
+
+  std::size_t size() const {
+    return points.size();
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    std::size_t nPoints = points.size();
+    for (std::size_t i = begin; i < end; i++) {
+      const StorePoint& point = points[i];
+      if (point.row < 0) {
+        for (std::size_t j = 0; shades != NULL && j < times.size(); j++) {
+          shades[i + nPoints * j] = unknown;
+        }
+        if (durations != NULL) {
+          durations[i] = NAN;
+        }
+        continue;
+      }
+      const T* cell = cube + (std::size_t)header.nAzimuths * (point.row + (std::size_t)header.nrow * point.col);
+      double total = 0;
+      for (std::size_t j = 0; j < times.size(); j++) {
+        SunPosition sun = getSunPosition(times[j], point.lat, point.lon, correctRefraction);
+        int layer = getAzimuthLayer(sun.azimuth, header.azimuthMin, header.azimuthStep, header.nAzimuths);
+        if (layer < 0) {
+          if (shades != NULL) {
+            shades[i + nPoints * j] = unknown;
+          }
+          continue;
+        }
+        bool shaded = HorizonType<T>::threshold(sun.altitude) < cell[layer];
+        if (shades != NULL) {
+          shades[i + nPoints * j] = shaded ? 1 : 0;
+        }
+        if (!shaded && sun.altitude >= sunriseAltitude) {
+          total += weight;
+        }
+      }
+      if (durations != NULL) {
+        durations[i] = total;
+      }
+    }
+  }
+
+private:
+  StoreHeader header;
+  const T* cube;
+  const std::vector<StorePoint>& points;
+  const std::vector<double>& times;
+  bool correctRefraction;
+  int* shades;
+  int unknown;
+  double* durations;
+  double weight;
+};
+
+} // namespace sunlight
+
+#endif
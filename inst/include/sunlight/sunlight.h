@@ -0,0 +1,32 @@
+#ifndef SUNLIGHT_SUNLIGHT_H
+#define SUNLIGHT_SUNLIGHT_H
+
+// header-only core of sunlightRCPP: horizon angles, shades and sunlight on raw
+// grids, without any dependency on R. src/ wraps it for R via Rcpp. the file
+// backed horizon store (store.h), the GeoTIFF writer (tiff.h, needs zlib) and
+// its writer threads (pipeline.h) pull in system headers and are included by
+// their users only
+
+#include "util.h"
+#include "grid.h"
+#include "pyramid.h"
+#include "session.h"
+#include "azimuth.h"
+#include "quantization.h"
+#include "horizon.h"
+#include "farfield.h"
+#include "points.h"
+#include "shadow.h"
+#include "mask.h"
+#include "ranges.h"
+#include "threshold.h"
+#include "duration.h"
+#include "sunrise.h"
+#include "solar.h"
+#include "update.h"
+#include "tiling.h"
+#include "stats.h"
+#include "schedule.h"
+#include "parallel.h"
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef SUNLIGHT_SUNRISE_H
+#define SUNLIGHT_SUNRISE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "quantization.h"
+#include "solar.h"
+#include "util.h"
+
+namespace sunlight {
+
+// terrain sunrise, sunset and sunlight duration per cell without sampling
+// the day in timesteps. between the azimuths of two adjacent layers a cell's
+// horizon is taken as linear in azimuth, so along the sun's track the margin
+// of the sun over the horizon only bends where the track passes a layer's
+// azimuth. the track is cut there (and at the sun's rise and set), and the
+// cell is lit where the margin, linear in time between the cuts, is not
+// negative: the crossings of the sun with the horizon come out to the
+// second for the cost of a read of each layer the sun passes
+
+// a cut of the sun's track: the sun at time, and the horizon there, layer
+// interpolated towards next by fraction, or none (layer -1) outside the
+// azimuths of the layers. daylightAfter is false for the night following a
+// sunset
+struct TrackKnot {
+  double time;
+  double altitude;
+  int layer;
+  int next;
+  double fraction;
+  bool daylightAfter;
+};
+
+// horizon position of azimuth among the nAzimuths layers of azimuths
+// azimuthMin + k * azimuthStep: interpolated between two layers, or across
+// north if the layers go round, and up to half a step past the end layers
+// as those (see getAzimuthLayer)
+inline void setTrackLayer(TrackKnot& knot, double azimuth, double azimuthMin, double azimuthStep, int nAzimuths) {
+  const double tolerance = 1e-6;
+  double offset = dmod(azimuth - azimuthMin, 360);
+  if (offset < 0) {
+    offset += 360;
+  }
+  double position = offset / azimuthStep;
+  bool fullCircle = nAzimuths * azimuthStep >= 360 - tolerance;
+  knot.layer = -1;
+  knot.next = -1;
+  knot.fraction = 0;
+  if (fullCircle) {
+    knot.layer = std::min((int)floor(position), nAzimuths - 1);
+    knot.next = (knot.layer + 1) % nAzimuths;
+    knot.fraction = std::min(1.0, position - knot.layer);
+  } else if (position <= nAzimuths - 1) {
+    knot.layer = (int)floor(position);
+    knot.next = std::min(knot.layer + 1, nAzimuths - 1);
+    knot.fraction = position - knot.layer;
+  } else if (position <= nAzimuths - 0.5 + tolerance) {
+    knot.layer = knot.next = nAzimuths - 1;
+  } else if (360 / azimuthStep - position <= 0.5 + tolerance) {
+    knot.layer = knot.next = 0;
+  }
+}
+
+// wrapped difference of two azimuths, in (-180, 180]
+inline double azimuthDifference(double a, double b) {
+  double difference = dmod(a - b, 360);
+  if (difference > 180) {
+    difference -= 360;
+  } else if (difference <= -180) {
+    difference += 360;
+  }
+  return difference;
+}
+
+// cuts of the sun's track from timeStart to timeStop at location lat/lon
+// over layers of azimuths azimuthMin + k * azimuthStep (k < nAzimuths): the
+// times the sun passes a layer's azimuth or the edges half a step past the
+// end layers, and the sun's rise and set (at sunriseAltitude), each found by
+// bisection to within precision seconds from a scan every scanStep seconds.
+// night is left out, apart from the cuts of rise and set
+inline std::vector<TrackKnot> getSunTrack(
+    double timeStart,
+    double timeStop,
+    double lat,
+    double lon,
+    double azimuthMin,
+    double azimuthStep,
+    int nAzimuths,
+    double scanStep = 60,
+    double precision = 0.5
+  ) {
+  std::vector<double> targets;
+  for (int k = 0; k < nAzimuths; k++) {
+    targets.push_back(azimuthMin + k * azimuthStep);
+  }
+  if (nAzimuths * azimuthStep < 360) {
+    targets.push_back(azimuthMin - azimuthStep / 2);
+    targets.push_back(azimuthMin + (nAzimuths - 0.5) * azimuthStep);
+  }
+
+  std::vector<double> times;
+  SunPosition start = getSunPosition(timeStart, lat, lon);
+  if (start.altitude >= sunriseAltitude) {
+    times.push_back(timeStart);
+  }
+  double t0 = timeStart;
+  SunPosition p0 = start;
+  while (t0 < timeStop) {
+    double t1 = std::min(timeStop, t0 + scanStep);
+    SunPosition p1 = getSunPosition(t1, lat, lon);
+    // rise or set
+    if ((p0.altitude >= sunriseAltitude) != (p1.altitude >= sunriseAltitude)) {
+      double a = t0, b = t1;
+      bool upAtA = p0.altitude >= sunriseAltitude;
+      while (b - a > precision) {
+        double m = (a + b) / 2;
+        if ((getSunPosition(m, lat, lon).altitude >= sunriseAltitude) == upAtA) {
+          a = m;
+        } else {
+          b = m;
+        }
+      }
+      times.push_back((a + b) / 2);
+    }
+    // layer azimuths passed while up
+    if (p0.altitude >= sunriseAltitude || p1.altitude >= sunriseAltitude) {
+      double swept = azimuthDifference(p1.azimuth, p0.azimuth);
+      for (std::size_t k = 0; k < targets.size(); k++) {
+        double offset = azimuthDifference(targets[k], p0.azimuth);
+        if (swept == 0 || offset == 0 || (offset > 0) != (swept > 0) || fabs(offset) > fabs(swept)) {
+          continue;
+        }
+        double a = t0, b = t1;
+        while (b - a > precision) {
+          double m = (a + b) / 2;
+          double passed = azimuthDifference(getSunPosition(m, lat, lon).azimuth, p0.azimuth);
+          if (fabs(passed) < fabs(offset) && (passed > 0) == (swept > 0)) {
+            a = m;
+          } else {
+            b = m;
+          }
+        }
+        double time = (a + b) / 2;
+        if (getSunPosition(time, lat, lon).altitude >= sunriseAltitude) {
+          times.push_back(time);
+        }
+      }
+    }
+    t0 = t1;
+    p0 = p1;
+  }
+  if (p0.altitude >= sunriseAltitude && timeStop > timeStart) {
+    times.push_back(timeStop);
+  }
+  std::sort(times.begin(), times.end());
+  times.erase(std::unique(times.begin(), times.end()), times.end());
+  // the sun's altitude and azimuth are not linear in time between two cuts:
+  // a cut halfway halves the error of the crossings for no extra layer reads
+  for (std::size_t k = 0, n = times.size(); k + 1 < n; k++) {
+    times.push_back((times[k] + times[k + 1]) / 2);
+  }
+  std::sort(times.begin(), times.end());
+
+  std::vector<TrackKnot> knots(times.size());
+  for (std::size_t k = 0; k < times.size(); k++) {
+    SunPosition position = getSunPosition(times[k], lat, lon);
+    knots[k].time = times[k];
+    // rise and set are found to within precision, put them on the threshold
+    knots[k].altitude = std::max(position.altitude, sunriseAltitude);
+    setTrackLayer(knots[k], position.azimuth, azimuthMin, azimuthStep, nAzimuths);
+    // a sunset followed by the next sunrise
+    knots[k].daylightAfter = true;
+  }
+  for (std::size_t k = 0; k + 1 < knots.size(); k++) {
+    double middle = (knots[k].time + knots[k + 1].time) / 2;
+    knots[k].daylightAfter = getSunPosition(middle, lat, lon).altitude >= sunriseAltitude;
+  }
+  return knots;
+}
+
+// first and last time a cell is lit and its lit seconds, along a track of
+// getSunTrack, for cells [begin, end) of a cube whose layer l of cell i is at
+// altitudes[l * layerStride + i * cellStride]. a cell is lit where the sun
+// is above sunriseAltitude and not below its horizon, as for DurationJob;
+// NA horizons count as shaded. sunrise and sunset are NA for cells never
+// lit. quantized horizons are interpolated in degrees
+template <typename T>
+class SunriseJob {
+public:
+  SunriseJob(
+      const T* altitudes,
+      std::size_t nCells,
+      std::ptrdiff_t layerStride,
+      std::ptrdiff_t cellStride,
+      const std::vector<TrackKnot>& knots,
+      double* sunrise,
+      double* sunset,
+      double* duration
+    ) :
+    altitudes(altitudes),
+    nCells(nCells),
+    layerStride(layerStride),
+    cellStride(cellStride),
+    knots(knots),
+    sunrise(sunrise),
+    sunset(sunset),
+    duration(duration) {
+    // the knots as flat arrays in the units of T, for a loop without
+    // branches over them; knots outside the layers get a NaN sun
+    double scale = HorizonType<T>::scale();
+    for (std::size_t k = 0; k < knots.size(); k++) {
+      bool inside = knots[k].layer >= 0;
+      first.push_back(inside ? knots[k].layer * layerStride : 0);
+      second.push_back(inside ? knots[k].next * layerStride : 0);
+      fractions.push_back(knots[k].fraction);
+      sun.push_back(inside ? knots[k].altitude / scale : NAN);
+    }
+    sunriseFloor = sunriseAltitude / scale;
+  }
+
+  std::size_t size() const {
+    return nCells;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    std::vector<double> margins(knots.size());
+    for (std::size_t i = begin; i < end; i++) {
+      const T* cell = altitudes + i * cellStride;
+      for (std::size_t k = 0; k < knots.size(); k++) {
+        // sun over the horizon, interpolated between two layers
+        double h0 = cell[first[k]];
+        double horizon = h0 + fractions[k] * (cell[second[k]] - h0);
+        margins[k] = sun[k] - std::max(horizon, sunriseFloor);
+      }
+      double rise = NAN, set = NAN, lit = 0;
+      for (std::size_t k = 0; k + 1 < knots.size(); k++) {
+        const TrackKnot& a = knots[k];
+        const TrackKnot& b = knots[k + 1];
+        double m0 = margins[k], m1 = margins[k + 1];
+        if (!a.daylightAfter || !(m0 >= 0 || m1 >= 0)) {
+          continue;
+        }
+        double from = a.time, to = b.time;
+        if (!(m0 >= 0)) {
+          from = isNA(m0) ? b.time : a.time + (b.time - a.time) * m0 / (m0 - m1);
+        } else if (!(m1 >= 0)) {
+          to = isNA(m1) ? a.time : a.time + (b.time - a.time) * m0 / (m0 - m1);
+        }
+        if (to < from) {
+          continue;
+        }
+        if (isNA(rise)) {
+          rise = from;
+        }
+        set = to;
+        lit += to - from;
+      }
+      // a sun up at a single knot only
+      if (knots.size() == 1 && margins[0] >= 0) {
+        rise = set = knots[0].time;
+      }
+      sunrise[i] = rise;
+      sunset[i] = set;
+      duration[i] = lit;
+    }
+  }
+
+private:
+  const T* altitudes;
+  std::size_t nCells;
+  std::ptrdiff_t layerStride;
+  std::ptrdiff_t cellStride;
+  std::vector<TrackKnot> knots;
+  double* sunrise;
+  double* sunset;
+  double* duration;
+  std::vector<std::ptrdiff_t> first; // offset of the layer of each knot
+  std::vector<std::ptrdiff_t> second; // and of the layer it interpolates to
+  std::vector<double> fractions;
+  std::vector<double> sun; // altitude, in units of T
+  double sunriseFloor; // sunriseAltitude, in units of T
+};
+
+} // namespace sunlight
+
+#endif
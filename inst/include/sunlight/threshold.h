@@ -0,0 +1,112 @@
+#ifndef SUNLIGHT_THRESHOLD_H
+#define SUNLIGHT_THRESHOLD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+#include "mask.h"
+#include "quantization.h"
+#include "ranges.h"
+
+namespace sunlight {
+
+// per cell shade (1) or, with sunlight, sunlight (1) for a sun at
+// minAltitude, over the cells [begin, end) of an altitude layer. compares in
+// the storage type T of the altitudes, quantized counts are never expanded
+// back to angles; the loop has no branches, so it vectorises
+template <typename T>
+void thresholdAltitudes(
+    const T* altitudes,
+    double* output,
+    std::size_t begin,
+    std::size_t end,
+    double minAltitude,
+    bool sunlight
+  ) {
+  typename HorizonType<T>::threshold_type threshold = HorizonType<T>::threshold(minAltitude);
+  const int flip = sunlight ? 1 : 0;
+  for (std::size_t i = begin; i < end; i++) {
+    output[i] = (threshold < altitudes[i]) ^ flip;
+  }
+}
+
+// thresholdAltitudes over a layer of nCells cells, into doubles or into a
+// bit-packed mask (see mask.h). a task is a word of 64 cells either way.
+// with ranges of the layer (see HorizonRanges), runs of cells in a tile the
+// sun is above or below the range of are filled without reading them
+template <typename T>
+class ThresholdJob {
+public:
+  ThresholdJob(const T* altitudes, std::size_t nCells, double minAltitude, bool sunlight, double* output, const HorizonRanges<T>* ranges = NULL) :
+    altitudes(altitudes),
+    nCells(nCells),
+    minAltitude(minAltitude),
+    sunlight(sunlight),
+    output(output),
+    mask(NULL),
+    ranges(ranges) {}
+
+  ThresholdJob(const T* altitudes, std::size_t nCells, double minAltitude, bool sunlight, uint64_t* mask, const HorizonRanges<T>* ranges = NULL) :
+    altitudes(altitudes),
+    nCells(nCells),
+    minAltitude(minAltitude),
+    sunlight(sunlight),
+    output(NULL),
+    mask(mask),
+    ranges(ranges) {}
+
+  std::size_t size() const {
+    return maskWords(nCells);
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    if (ranges && mask) {
+      unsigned char flags[64];
+      for (std::size_t w = begin; w < end; w++) {
+        std::size_t first = w * 64;
+        std::size_t last = std::min(nCells, first + 64);
+        std::fill(flags, flags + 64, 0);
+        thresholdTiles(first, last, flags);
+        mask[w] = packFlags(flags);
+      }
+    } else if (ranges) {
+      thresholdTiles(begin * 64, std::min(nCells, end * 64), output + begin * 64);
+    } else if (mask) {
+      thresholdMask(altitudes, 1, nCells, HorizonType<T>::threshold(minAltitude), sunlight, mask, begin, end);
+    } else {
+      thresholdAltitudes(altitudes, output, begin * 64, std::min(nCells, end * 64), minAltitude, sunlight);
+    }
+  }
+
+private:
+  // flags of cells [first, last) to out[i - first], a tile run at a time
+  template <typename O>
+  void thresholdTiles(std::size_t first, std::size_t last, O* out) const {
+    typename HorizonType<T>::threshold_type threshold = HorizonType<T>::threshold(minAltitude);
+    const int flip = sunlight ? 1 : 0;
+    for (std::size_t i = first; i < last;) {
+      std::size_t runEnd = ranges->runEnd(i, last);
+      int shade = ranges->shade(ranges->index(i, 0), threshold);
+      if (shade < 0) {
+        for (std::size_t k = i; k < runEnd; k++) {
+          out[k - first] = (threshold < altitudes[k]) ^ flip;
+        }
+      } else {
+        std::fill(out + (i - first), out + (runEnd - first), (O)(shade ^ flip));
+      }
+      i = runEnd;
+    }
+  }
+
+  const T* altitudes;
+  std::size_t nCells;
+  double minAltitude;
+  bool sunlight;
+  double* output;
+  uint64_t* mask;
+  const HorizonRanges<T>* ranges;
+};
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef SUNLIGHT_TIFF_H
+#define SUNLIGHT_TIFF_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#ifdef SUNLIGHT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "grid.h"
+
+namespace sunlight {
+
+// single band, tiled GeoTIFFs of horizon layers, written without GDAL so
+// background threads can compress and write while the next layers compute
+// (see JobPipeline). angles go to 32 bit floats, quantized counts stay
+// uint16 or uint8, compressed with the horizontal differencing predictor.
+// tiles are deflated with zlib, or with zstd where the package is built with
+// SUNLIGHT_HAVE_ZSTD, which src/Makevars defines where pkg-config finds
+// libzstd (GDAL reads both). classic TIFF, so a file stays below 4 GB, in
+// native byte order
+
+enum TiffCompression {
+  TIFF_NONE = 1,
+  TIFF_DEFLATE = 8,
+  TIFF_ZSTD = 50000
+};
+
+// "none", "deflate" or "zstd"
+inline TiffCompression parseCompression(const std::string& compression) {
+  if (compression == "none") {
+    return TIFF_NONE;
+  } else if (compression == "deflate") {
+    return TIFF_DEFLATE;
+  } else if (compression == "zstd") {
+#ifdef SUNLIGHT_HAVE_ZSTD
+    return TIFF_ZSTD;
+#else
+    throw std::invalid_argument("built without zstd, use deflate");
+#endif
+  }
+  throw std::invalid_argument("unknown compression: " + compression);
+}
+
+// sample type of the file for a layer type, and its tags. the predictor is
+// the one of compressed files: readers only undo it inside a codec, so
+// uncompressed files go without (see tiffPredictor)
+template <typename T> struct TiffSample;
+template <> struct TiffSample<double> {
+  typedef float type;
+  static uint16_t format() { return 3; }
+  static uint16_t predictor() { return 1; }
+};
+template <> struct TiffSample<uint16_t> {
+  typedef uint16_t type;
+  static uint16_t format() { return 1; }
+  static uint16_t predictor() { return 2; }
+};
+template <> struct TiffSample<uint8_t> {
+  typedef uint8_t type;
+  static uint16_t format() { return 1; }
+  static uint16_t predictor() { return 2; }
+};
+
+// predictor of a file of T samples compressed with compression
+template <typename T>
+uint16_t tiffPredictor(TiffCompression compression) {
+  return compression == TIFF_NONE ? 1 : TiffSample<T>::predictor();
+}
+
+// the rows [row, row + nrow) and columns [col, col + ncol) of a layer
+struct TiffWindow {
+  int row;
+  int col;
+  int nrow;
+  int ncol;
+};
+
+// entries of a TIFF directory, added in the order of their tags
+class TiffDirectory {
+public:
+  void addShort(uint16_t tag, uint16_t value) {
+    addShorts(tag, std::vector<uint16_t>(1, value));
+  }
+
+  void addShorts(uint16_t tag, const std::vector<uint16_t>& values) {
+    add(tag, 3, values.size(), &values[0], values.size() * 2);
+  }
+
+  void addLong(uint16_t tag, uint32_t value) {
+    addLongs(tag, std::vector<uint32_t>(1, value));
+  }
+
+  void addLongs(uint16_t tag, const std::vector<uint32_t>& values) {
+    add(tag, 4, values.size(), &values[0], values.size() * 4);
+  }
+
+  void addDoubles(uint16_t tag, const double* values, std::size_t count) {
+    add(tag, 12, count, values, count * 8);
+  }
+
+  // the directory at offset: entries, the offset of the next directory (0)
+  // and the values too large for their entry
+  std::vector<unsigned char> bytes(uint32_t offset) const {
+    uint16_t count = entries.size();
+    std::size_t size = 2 + 12 * entries.size() + 4;
+    std::vector<unsigned char> out(size);
+    std::memcpy(&out[0], &count, 2);
+    for (std::size_t e = 0; e < entries.size(); e++) {
+      const Entry& entry = entries[e];
+      unsigned char* slot = &out[2 + 12 * e];
+      std::memcpy(slot, &entry.tag, 2);
+      std::memcpy(slot + 2, &entry.type, 2);
+      std::memcpy(slot + 4, &entry.count, 4);
+      if (entry.value.size() <= 4) {
+        std::memcpy(slot + 8, &entry.value[0], entry.value.size());
+      } else {
+        if (out.size() % 2) {
+          out.push_back(0);
+        }
+        uint32_t valueOffset = offset + out.size();
+        std::memcpy(slot + 8, &valueOffset, 4);
+        out.insert(out.end(), entry.value.begin(), entry.value.end());
+      }
+    }
+    return out;
+  }
+
+private:
+  struct Entry {
+    uint16_t tag;
+    uint16_t type;
+    uint32_t count;
+    std::vector<unsigned char> value;
+  };
+
+  void add(uint16_t tag, uint16_t type, std::size_t count, const void* values, std::size_t size) {
+    Entry entry;
+    entry.tag = tag;
+    entry.type = type;
+    entry.count = count;
+    const unsigned char* bytes = static_cast<const unsigned char*>(values);
+    entry.value.assign(bytes, bytes + size);
+    entries.push_back(entry);
+  }
+
+  std::vector<Entry> entries;
+};
+
+// writes size bytes to file, throwing on failure
+inline void writeBytes(FILE* file, const std::string& path, const void* bytes, std::size_t size) {
+  if (std::fwrite(bytes, 1, size, file) != size) {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+// compresses size bytes into packed, returning the compressed size
+inline std::size_t compressTile(
+    TiffCompression compression,
+    const unsigned char* bytes,
+    std::size_t size,
+    std::vector<unsigned char>& packed,
+    const std::string& path
+  ) {
+  if (compression == TIFF_ZSTD) {
+#ifdef SUNLIGHT_HAVE_ZSTD
+    packed.resize(ZSTD_compressBound(size));
+    std::size_t packedSize = ZSTD_compress(&packed[0], packed.size(), bytes, size, 1);
+    if (ZSTD_isError(packedSize)) {
+      throw std::runtime_error("cannot compress " + path);
+    }
+    return packedSize;
+#else
+    throw std::invalid_argument("built without zstd, use deflate");
+#endif
+  }
+  uLongf packedSize = compressBound(size);
+  packed.resize(packedSize);
+  if (compress2(&packed[0], &packedSize, bytes, size, 6) != Z_OK) {
+    throw std::runtime_error("cannot compress " + path);
+  }
+  return packedSize;
+}
+
+// writes window of a layer of the grid at georeference to path, cell i of
+// the layer at layer[i * cellStride] in column-major order, so a layer of a
+// horizon cube is written in place. epsg is the code of the projected
+// coordinate system of the grid, or 0 for none
+template <typename T>
+void writeGeoTiff(
+    const std::string& path,
+    const T* layer,
+    std::ptrdiff_t cellStride,
+    int nrow,
+    const TiffWindow& window,
+    const Georeference& georeference,
+    int epsg,
+    TiffCompression compression,
+    int tileSize = 256
+  ) {
+  typedef typename TiffSample<T>::type S;
+  uint16_t predictor = tiffPredictor<T>(compression);
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  try {
+    // header, the offset of the directory patched in at the end
+    uint16_t one = 1;
+    bool littleEndian = *reinterpret_cast<unsigned char*>(&one) == 1;
+    const char order[2] = {littleEndian ? 'I' : 'M', littleEndian ? 'I' : 'M'};
+    uint16_t magic = 42;
+    uint32_t directoryOffset = 0;
+    writeBytes(file, path, order, 2);
+    writeBytes(file, path, &magic, 2);
+    writeBytes(file, path, &directoryOffset, 4);
+
+    int tilesAcross = (window.ncol + tileSize - 1) / tileSize;
+    int tilesDown = (window.nrow + tileSize - 1) / tileSize;
+    std::vector<uint32_t> offsets, byteCounts;
+    std::vector<S> tile((std::size_t)tileSize * tileSize);
+    std::vector<unsigned char> packed;
+    uint64_t position = 8;
+    for (int tileRow = 0; tileRow < tilesDown; tileRow++) {
+      for (int tileCol = 0; tileCol < tilesAcross; tileCol++) {
+        // pixels row by row, edge tiles padded with 0
+        std::fill(tile.begin(), tile.end(), S(0));
+        int rows = std::min(tileSize, window.nrow - tileRow * tileSize);
+        int cols = std::min(tileSize, window.ncol - tileCol * tileSize);
+        for (int c = 0; c < cols; c++) {
+          std::size_t col = window.col + tileCol * tileSize + c;
+          const T* cells = layer + (window.row + tileRow * tileSize + col * nrow) * cellStride;
+          for (int r = 0; r < rows; r++) {
+            tile[(std::size_t)r * tileSize + c] = (S)cells[r * cellStride];
+          }
+        }
+        if (predictor == 2) {
+          for (int r = 0; r < tileSize; r++) {
+            S* pixels = &tile[(std::size_t)r * tileSize];
+            for (int c = tileSize - 1; c > 0; c--) {
+              pixels[c] = (S)(pixels[c] - pixels[c - 1]);
+            }
+          }
+        }
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&tile[0]);
+        std::size_t size = tile.size() * sizeof(S);
+        if (compression != TIFF_NONE) {
+          size = compressTile(compression, bytes, size, packed, path);
+          bytes = &packed[0];
+        }
+        if (position + size >= 0xffffffffULL) {
+          throw std::runtime_error("too large for a classic tiff: " + path);
+        }
+        writeBytes(file, path, bytes, size);
+        offsets.push_back((uint32_t)position);
+        byteCounts.push_back((uint32_t)size);
+        position += size;
+      }
+    }
+    if (position % 2) {
+      // the directory starts on a word boundary
+      writeBytes(file, path, "", 1);
+      position++;
+    }
+
+    // the directory, its entries sorted by tag, then the values that do not
+    // fit into an entry
+    TiffDirectory directory;
+    directory.addLong(256, window.ncol);
+    directory.addLong(257, window.nrow);
+    directory.addShort(258, 8 * sizeof(S));
+    directory.addShort(259, compression);
+    directory.addShort(262, 1); // black is zero
+    directory.addShort(277, 1);
+    directory.addShort(284, 1);
+    directory.addShort(317, predictor);
+    directory.addLong(322, tileSize);
+    directory.addLong(323, tileSize);
+    directory.addLongs(324, offsets);
+    directory.addLongs(325, byteCounts);
+    directory.addShort(339, TiffSample<T>::format());
+    double scale[3] = {georeference.xres, georeference.yres, 0};
+    directory.addDoubles(33550, scale, 3);
+    double tiepoint[6] = {
+      0, 0, 0,
+      georeference.xmin + window.col * georeference.xres,
+      georeference.ymax - window.row * georeference.yres,
+      0
+    };
+    directory.addDoubles(33922, tiepoint, 6);
+    // geokeys: model type projected, raster type pixel is area, the
+    // projected coordinate system
+    std::vector<uint16_t> keys;
+    uint16_t header[4] = {1, 1, 0, 0};
+    keys.insert(keys.end(), header, header + 4);
+    if (epsg > 0) {
+      uint16_t modelType[4] = {1024, 0, 1, 1};
+      keys.insert(keys.end(), modelType, modelType + 4);
+    }
+    uint16_t rasterType[4] = {1025, 0, 1, 1};
+    keys.insert(keys.end(), rasterType, rasterType + 4);
+    if (epsg > 0) {
+      uint16_t projected[4] = {3072, 0, 1, (uint16_t)epsg};
+      keys.insert(keys.end(), projected, projected + 4);
+    }
+    keys[3] = keys.size() / 4 - 1;
+    directory.addShorts(34735, keys);
+    std::vector<unsigned char> bytes = directory.bytes((uint32_t)position);
+    if (position + bytes.size() >= 0xffffffffULL) {
+      throw std::runtime_error("too large for a classic tiff: " + path);
+    }
+    writeBytes(file, path, &bytes[0], bytes.size());
+    directoryOffset = (uint32_t)position;
+    if (std::fseek(file, 4, SEEK_SET) != 0) {
+      throw std::runtime_error("cannot write " + path);
+    }
+    writeBytes(file, path, &directoryOffset, 4);
+  } catch (...) {
+    std::fclose(file);
+    throw;
+  }
+  if (std::fclose(file) != 0) {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+} // namespace sunlight
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SUNLIGHT_TILING_H
+#define SUNLIGHT_TILING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "util.h"
+
+namespace sunlight {
+
+// dems too large for memory are processed in tiles. a tile's horizons only
+// need the terrain that can still shade it: with relief (m) between the
+// lowest and highest cell, terrain further away than relief / tan(a) stays
+// below altitude a, so for sun altitudes of at least minSunAltitude a tile
+// plus a halo of that reach gives the same shade as the whole dem. horizon
+// angles below minSunAltitude may come out lower than on the whole dem.
+// curvature only lowers far terrain, so the reach holds with corrections too
+
+// shadow reach in cells of resolution (m), at least 0. a sun on or below
+// the horizon has no bound, which is capped at maxShadowReach
+const int maxShadowReach = 1000000000;
+
+inline int getShadowReach(double relief, double minSunAltitude, double resolution) {
+  if (!(relief > 0)) {
+    return 0;
+  }
+  if (!(minSunAltitude > 0)) {
+    return maxShadowReach;
+  }
+  double reach = std::ceil(relief / tan(deg2rad(minSunAltitude)) / resolution);
+  return reach < maxShadowReach ? (int)reach : maxShadowReach;
+}
+
+// core cells [row, row + nrow) x [col, col + ncol) of a tile, computed on
+// the window of the dem extended by the halo and clipped to the grid
+struct Tile {
+  int row;
+  int col;
+  int nrow;
+  int ncol;
+  int windowRow;
+  int windowCol;
+  int windowNrow;
+  int windowNcol;
+};
+
+// tiles of at most tileSize x tileSize cells covering an nrow x ncol grid,
+// row-major
+inline std::vector<Tile> planTiles(int nrow, int ncol, int tileSize, int halo) {
+  std::vector<Tile> tiles;
+  for (int row = 0; row < nrow; row += tileSize) {
+    for (int col = 0; col < ncol; col += tileSize) {
+      Tile tile;
+      tile.row = row;
+      tile.col = col;
+      tile.nrow = std::min(tileSize, nrow - row);
+      tile.ncol = std::min(tileSize, ncol - col);
+      tile.windowRow = std::max(0, row - halo);
+      tile.windowCol = std::max(0, col - halo);
+      tile.windowNrow = std::min(nrow, row + tile.nrow + halo) - tile.windowRow;
+      tile.windowNcol = std::min(ncol, col + tile.ncol + halo) - tile.windowCol;
+      tiles.push_back(tile);
+    }
+  }
+  return tiles;
+}
+
+// copy the layers of the core cells of tile from its window cube (layers
+// adjacent per cell, column-major cells of the window) into layers
+// firstLayer.. of a cube of the whole grid with nLayers per cell and nrow rows
+template <typename T>
+void copyTileLayers(
+    const T* window,
+    int windowLayers,
+    const Tile& tile,
+    T* cube,
+    int nLayers,
+    int firstLayer,
+    int nrow
+  ) {
+  int rowShift = tile.row - tile.windowRow;
+  int colShift = tile.col - tile.windowCol;
+  for (int c = 0; c < tile.ncol; c++) {
+    for (int r = 0; r < tile.nrow; r++) {
+      const T* from = window + (std::size_t)windowLayers * (r + rowShift + (std::size_t)tile.windowNrow * (c + colShift));
+      T* to = cube + (std::size_t)nLayers * (tile.row + r + (std::size_t)nrow * (tile.col + c)) + firstLayer;
+      std::copy(from, from + windowLayers, to);
+    }
+  }
+}
+
+} // namespace sunlight
+
+#endif
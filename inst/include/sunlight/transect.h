@@ -0,0 +1,104 @@
+#ifndef SUNLIGHT_TRANSECT_H
+#define SUNLIGHT_TRANSECT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+#include "azimuth.h"
+#include "util.h"
+
+namespace sunlight {
+
+// the sampled transect of a cell depends on the azimuth only, so the samples
+// are laid out once per azimuth and shared by every cell: step factor, row
+// and column offset, offset into the dem, distance and surface drop of each.
+// the offsets only ever move away from the origin, so the samples within the
+// grid are a prefix of the template, whose length follows from the distance
+// of the cell to the two edges the transect runs towards (see samples()).
+// samples from maxDistance on are left out, for terrain beyond it read
+// from elsewhere (see FarField)
+struct TransectTemplate {
+  std::vector<int> stepFactors;
+  std::vector<int> rowOffsets;
+  std::vector<int> colOffsets;
+  std::vector<std::ptrdiff_t> offsets;
+  std::vector<double> distances;
+  std::vector<double> drops; // 0 without curvature correction
+  std::vector<int> rowLimits; // samples within [e] rows of the origin
+  std::vector<int> colLimits; // samples within [e] columns of the origin
+  bool up; // transect runs towards row 0
+  bool left; // transect runs towards column 0
+
+  TransectTemplate(
+      const AzimuthSteps& steps,
+      double incFactor,
+      int nrow,
+      int ncol,
+      std::ptrdiff_t rowStride,
+      std::ptrdiff_t colStride,
+      bool correctCurvature,
+      bool correctRefraction,
+      double maxDistance = INFINITY
+    ) :
+    up(steps.dy < 0),
+    left(steps.dx < 0) {
+    // one of |dx|, |dy| is 1, so no sample beyond max(nrow, ncol) is inside
+    int maxStepFactor = std::max(nrow, ncol);
+    int step = 0;
+    int stepFactor = 0;
+    while (true) {
+      // same sequence as the original per cell loop
+      double next = step + pow(incFactor, step + 1);
+      if (next > maxStepFactor || steps.dxy * (int)next >= maxDistance) {
+        break;
+      }
+      stepFactor = next;
+      step++;
+      int rowOffset = round(steps.dy * stepFactor);
+      int colOffset = round(steps.dx * stepFactor);
+      double distance = steps.dxy * stepFactor;
+      double drop = 0;
+      if (correctCurvature) {
+        drop = correctRefraction ? getRefractedCurvatureCorrection(distance) : getCurvatureCorrection(distance);
+      }
+      stepFactors.push_back(stepFactor);
+      rowOffsets.push_back(rowOffset);
+      colOffsets.push_back(colOffset);
+      offsets.push_back(rowOffset * rowStride + colOffset * colStride);
+      distances.push_back(distance);
+      drops.push_back(drop);
+    }
+    rowLimits = getLimits(rowOffsets, nrow);
+    colLimits = getLimits(colOffsets, ncol);
+  }
+
+  int size() const {
+    return stepFactors.size();
+  }
+
+  // number of samples of the transect of cell (row, col) inside the grid
+  int samples(int row, int col, int nrow, int ncol) const {
+    int rowEdge = up ? row : nrow - 1 - row;
+    int colEdge = left ? col : ncol - 1 - col;
+    return std::min(rowLimits[rowEdge], colLimits[colEdge]);
+  }
+
+private:
+  static std::vector<int> getLimits(const std::vector<int>& offsets, int extent) {
+    std::vector<int> limits(extent);
+    int k = 0;
+    for (int edge = 0; edge < extent; edge++) {
+      while (k < (int)offsets.size() && std::abs(offsets[k]) <= edge) {
+        k++;
+      }
+      limits[edge] = k;
+    }
+    return limits;
+  }
+};
+
+} // namespace sunlight
+
+#endif
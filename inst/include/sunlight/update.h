@@ -0,0 +1,294 @@
+#ifndef SUNLIGHT_UPDATE_H
+#define SUNLIGHT_UPDATE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "azimuth.h"
+#include "farfield.h"
+#include "grid.h"
+#include "horizon.h"
+#include "pyramid.h"
+#include "quantization.h"
+#include "transect.h"
+#include "util.h"
+
+namespace sunlight {
+
+// a local edit of a dem (a building burnt in, an excavation) only changes
+// the horizons of the cells inside it and of the cells whose transects pass
+// through it. UpdateJob recomputes just those in an existing horizon cube,
+// giving the same cube as a full run on the edited dem
+
+// cells [row, row + nrow) x [col, col + ncol) of a grid
+struct CellBox {
+  int row;
+  int col;
+  int nrow;
+  int ncol;
+
+  bool contains(int r, int c) const {
+    return r >= row && r < row + nrow && c >= col && c < col + ncol;
+  }
+};
+
+// highest elevation of a dem inside box, ignoring NA cells (-Inf if none)
+template <typename E>
+double maxElevation(const GridView<const E>& dem, const CellBox& box) {
+  double maxElev = -INFINITY;
+  for (int col = box.col; col < box.col + box.ncol; col++) {
+    for (int row = box.row; row < box.row + box.nrow; row++) {
+      double elevation = dem(row, col);
+      if (elevation > maxElev) {
+        maxElev = elevation;
+      }
+    }
+  }
+  return maxElev;
+}
+
+// samples [first, last) among [from, to) whose offsets lie in [lo, hi), a
+// range as the offsets of a transect are monotonic: decreasing for
+// transects towards row or column 0
+inline void offsetRange(
+    const std::vector<int>& offsets,
+    bool decreasing,
+    int lo,
+    int hi,
+    int from,
+    int to,
+    int& first,
+    int& last
+  ) {
+  if (from >= to) {
+    first = last = from;
+    return;
+  }
+  const int* begin = &offsets[0] + from;
+  const int* end = &offsets[0] + to;
+  if (decreasing) {
+    first = std::lower_bound(begin, end, hi - 1, std::greater<int>()) - &offsets[0];
+    last = std::lower_bound(begin, end, lo - 1, std::greater<int>()) - &offsets[0];
+  } else {
+    first = std::lower_bound(begin, end, lo) - &offsets[0];
+    last = std::lower_bound(begin, end, hi) - &offsets[0];
+  }
+}
+
+// recomputes the horizons of an AltitudeJob output after the cells in box
+// changed, dem being the edited dem and output holding the horizons of the
+// dem before the edit, with the same azimuths and settings.
+// march: a cell outside the box is visited if one of its samples falls into
+// the box, and recomputed unless the box, at most previousMax high before
+// and as high as the edited terrain now, cannot reach the cell's current
+// horizon at its first sample inside; previousMax NaN means unknown, all
+// cells reaching the box are recomputed then.
+// lines, sweep: the lines through the box are recomputed in full.
+// altitudeCaps are the caps the output was computed with, if any; a cell
+// stored as neverSunlit stays so while the box cannot pass its cap. an
+// output computed with far fields needs the reach of that run and farField,
+// a FarFieldJob on output with its fields, which raises each recomputed cell
+// again
+template <typename E, typename T>
+class UpdateJob {
+public:
+  UpdateJob(
+      const GridView<const E>& dem,
+      T* output,
+      const std::vector<double>& azimuths,
+      double gridConvergence,
+      double resolution,
+      double incFactor,
+      Method method,
+      const CellBox& box,
+      double previousMax,
+      bool correctCurvature = false,
+      bool correctRefraction = false,
+      const std::vector<double>& altitudeCaps = std::vector<double>(),
+      double reach = INFINITY,
+      const FarFieldJob<E, T>* farField = NULL
+    ) :
+    dem(dem),
+    output(output),
+    method(method),
+    box(box),
+    farField(farField),
+    taskStart(1, 0),
+    updated(0) {
+    if (!altitudeCaps.empty() && altitudeCaps.size() != azimuths.size()) {
+      throw std::invalid_argument("altitudeCaps must have one cap per azimuth");
+    }
+    maxElev = maxElevation(dem);
+    boxMax = std::max(maxElevation(dem, box), previousMax);
+    if (isNA(previousMax)) {
+      boxMax = INFINITY;
+    }
+    if (correctCurvature && method == SWEEP) {
+      this->method = method = LINES;
+      incFactor = 1;
+    }
+    if (method == MARCH) {
+      pyramid.reset(new MaxPyramid(dem));
+    }
+    for (std::size_t a = 0; a < azimuths.size(); a++) {
+      steps.push_back(getAzimuthSteps(azimuths[a], gridConvergence, resolution));
+      lines.push_back(LineGeometry(steps[a].dx, steps[a].dy, dem.nrow, dem.ncol));
+      transects.push_back(TransectTemplate(
+          steps[a], incFactor, dem.nrow, dem.ncol, dem.rowStride, dem.colStride,
+          correctCurvature, correctRefraction, reach));
+      caps.push_back(altitudeCaps.empty() ? INFINITY : getCapTangent<T>(altitudeCaps[a]));
+      if (method == MARCH) {
+        taskStart.push_back(taskStart[a] + dem.ncol);
+      } else {
+        // lines through the box: those through its cells, a range
+        int first = lines[a].nLines;
+        int last = -1;
+        for (int col = box.col; col < box.col + box.ncol; col++) {
+          for (int row = box.row; row < box.row + box.nrow; row++) {
+            int line = lines[a].line(row, col);
+            first = std::min(first, line);
+            last = std::max(last, line);
+          }
+        }
+        firstLines.push_back(first);
+        taskStart.push_back(taskStart[a] + std::max(0, last - first + 1));
+      }
+    }
+  }
+
+  std::size_t size() const {
+    return taskStart.back();
+  }
+
+  GridView<T> layer(std::size_t a) const {
+    std::ptrdiff_t nAzimuths = steps.size();
+    return GridView<T>(output + a, dem.nrow, dem.ncol, nAzimuths, nAzimuths * dem.nrow);
+  }
+
+  Method effectiveMethod() const {
+    return method;
+  }
+
+  // cells recomputed so far, over all azimuths
+  unsigned long long updatedCells() const {
+    return updated;
+  }
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    LineBuffers buffers;
+    unsigned long long updatedRange = 0;
+    SearchCounters counters;
+    std::size_t a = std::upper_bound(taskStart.begin(), taskStart.end(), begin) - taskStart.begin() - 1;
+    for (std::size_t task = begin; task < end; task++) {
+      while (task >= taskStart[a + 1]) {
+        a++;
+      }
+      int unit = task - taskStart[a];
+      if (method == MARCH) {
+        updatedRange += updateColumn(a, unit, counters);
+      } else {
+        int line = firstLines[a] + unit;
+        if (method == SWEEP) {
+          sweepLine(dem, layer(a), line, lines[a], steps[a].dxy, buffers, counters, caps[a]);
+        } else {
+          marchLine(dem, layer(a), line, lines[a], transects[a], maxElev, true, buffers, counters, caps[a]);
+        }
+        for (int t = 0; t < lines[a].nMajor; t++) {
+          int row, col;
+          if (lines[a].cell(line, t, row, col)) {
+            updatedRange++;
+            if (farField) {
+              farField->raise(a, row, col);
+            }
+          }
+        }
+      }
+    }
+    updated += updatedRange;
+  }
+
+private:
+  // recompute the cells of column col of azimuth a that the edit can affect
+  unsigned long long updateColumn(std::size_t a, int col, SearchCounters& counters) const {
+    GridView<T> layer = this->layer(a);
+    const TransectTemplate& transect = transects[a];
+    double cap = caps[a];
+    T sentinel = HorizonType<T>::quantize(neverSunlit);
+    unsigned long long count = 0;
+    // samples landing in the box's columns, and the rows whose samples
+    // among those can land in its rows
+    int first, last;
+    offsetRange(transect.colOffsets, transect.left, box.col - col, box.col + box.ncol - col, 0, transect.size(), first, last);
+    int rowStart = dem.nrow;
+    int rowStop = 0;
+    if (first < last) {
+      int lowest = std::min(transect.rowOffsets[first], transect.rowOffsets[last - 1]);
+      int highest = std::max(transect.rowOffsets[first], transect.rowOffsets[last - 1]);
+      rowStart = std::max(0, box.row - highest);
+      rowStop = std::min(dem.nrow, box.row + box.nrow - lowest);
+    }
+    bool boxColumn = col >= box.col && col < box.col + box.ncol;
+    if (boxColumn) {
+      rowStart = std::min(rowStart, box.row);
+      rowStop = std::max(rowStop, box.row + box.nrow);
+    }
+    for (int row = rowStart; row < rowStop; row++) {
+      double elevationOrigin = dem(row, col);
+      if (!box.contains(row, col)) {
+        int k, kEnd;
+        offsetRange(transect.rowOffsets, transect.up, box.row - row, box.row + box.nrow - row, first, last, k, kEnd);
+        if (k >= kEnd || isNA(elevationOrigin)) {
+          continue;
+        }
+        // the box, old or new, cannot rise above this tangent from here. a
+        // horizon above the cap comes from elsewhere if the box stays below
+        double bound = (boxMax - elevationOrigin - transect.drops[k]) / transect.distances[k];
+        if (bound <= 0) {
+          continue;
+        } else if (cap < INFINITY && layer(row, col) == sentinel) {
+          if (bound <= cap) {
+            continue;
+          }
+        } else if (HorizonType<T>::quantize(rad2deg(atan(bound))) < layer(row, col)) {
+          continue;
+        }
+      }
+      double best = 0;
+      if (!isNA(elevationOrigin)) {
+        int n = transect.samples(row, col, dem.nrow, dem.ncol);
+        best = searchTransect(dem, row, col, elevationOrigin, transect, 0, n, best, maxElev, pyramid.get(), counters, cap);
+      }
+      layer(row, col) = storedHorizon<T>(best, cap);
+      if (farField) {
+        farField->raise(a, row, col);
+      }
+      count++;
+    }
+    return count;
+  }
+
+  GridView<const E> dem;
+  T* output;
+  Method method;
+  CellBox box;
+  const FarFieldJob<E, T>* farField;
+  double maxElev;
+  double boxMax; // highest the box was or is, Inf if unknown
+  std::unique_ptr<MaxPyramid> pyramid;
+  std::vector<AzimuthSteps> steps;
+  std::vector<LineGeometry> lines;
+  std::vector<TransectTemplate> transects;
+  std::vector<double> caps; // tangents
+  std::vector<int> firstLines; // first line through the box (lines, sweep)
+  std::vector<std::size_t> taskStart;
+  mutable std::atomic<unsigned long long> updated;
+};
+
+} // namespace sunlight
+
+#endif
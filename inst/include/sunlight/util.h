@@ -0,0 +1,53 @@
+#ifndef SUNLIGHT_UTIL_H
+#define SUNLIGHT_UTIL_H
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace sunlight {
+
+// modulo but for doubles
+// scribed from https://stackoverflow.com/a/53998265
+inline double dmod(double x, double y) {
+  return x - (int)(x/y) * y;
+}
+
+inline double deg2rad(double deg) {
+  return deg / 180 * M_PI;
+}
+
+inline double rad2deg(double rad) {
+  return rad * 180 / M_PI;
+}
+
+// drop of the earth's surface in m at distance (in m)
+inline double getCurvatureCorrection(double distance) {
+  // util
+  int radiusEarth = 6371000; // in m
+  // 2 * M_PI * radiusEarth;
+  double anglePerUnit = 0.000009;
+  // 360 / circumferenceEarth;
+  double totalAngle = anglePerUnit * distance; //  Unit degrees * distance
+  return radiusEarth * (1 - cos(deg2rad(totalAngle)));
+}
+
+// standard coefficient of atmospheric refraction: sight lines bend back
+// towards the surface, which hides a fraction of the curvature drop
+const double refractionCoefficient = 0.13;
+
+// apparent drop of the earth's surface in m at distance, with refraction
+inline double getRefractedCurvatureCorrection(double distance) {
+  return (1 - refractionCoefficient) * getCurvatureCorrection(distance);
+}
+
+// R's NA_real_ is a NaN, so this covers both
+inline bool isNA(double x) {
+  return std::isnan(x);
+}
+
+} // namespace sunlight
+
+#endif
@@ -10,13 +10,36 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// dem_session_cpp
+SEXP dem_session_cpp(NumericMatrix& dem, bool prune);
+RcppExport SEXP _sunlightRCPP_dem_session_cpp(SEXP demSEXP, SEXP pruneSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    rcpp_result_gen = Rcpp::wrap(dem_session_cpp(dem, prune));
+    return rcpp_result_gen;
+END_RCPP
+}
+// dem_session_info_cpp
+List dem_session_info_cpp(SEXP session);
+RcppExport SEXP _sunlightRCPP_dem_session_info_cpp(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(dem_session_info_cpp(session));
+    return rcpp_result_gen;
+END_RCPP
+}
 // get_altitude_distances_for_azimuth_cpp
-NumericMatrix get_altitude_distances_for_azimuth_cpp(NumericMatrix& dem, double azimuth, double gridConvergence, double resolution, bool correctCurvature, double incFactor);
+NumericMatrix get_altitude_distances_for_azimuth_cpp(SEXP dem, double azimuth, double gridConvergence, double resolution, bool correctCurvature, double incFactor);
 RcppExport SEXP _sunlightRCPP_get_altitude_distances_for_azimuth_cpp(SEXP demSEXP, SEXP azimuthSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
     Rcpp::traits::input_parameter< double >::type azimuth(azimuthSEXP);
     Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
     Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
@@ -27,78 +50,517 @@ BEGIN_RCPP
 END_RCPP
 }
 // get_altitudes_for_azimuth_cpp
-NumericMatrix get_altitudes_for_azimuth_cpp(NumericMatrix& dem, double azimuth, double gridConvergence, double resolution, bool correctCurvature, double incFactor);
-RcppExport SEXP _sunlightRCPP_get_altitudes_for_azimuth_cpp(SEXP demSEXP, SEXP azimuthSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP) {
+SEXP get_altitudes_for_azimuth_cpp(SEXP dem, double azimuth, double gridConvergence, double resolution, bool correctCurvature, double incFactor, std::string method, std::string quantize, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, bool stats, int numThreads, int grainSize, bool ranges);
+RcppExport SEXP _sunlightRCPP_get_altitudes_for_azimuth_cpp(SEXP demSEXP, SEXP azimuthSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP methodSEXP, SEXP quantizeSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP statsSEXP, SEXP numThreadsSEXP, SEXP grainSizeSEXP, SEXP rangesSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
     Rcpp::traits::input_parameter< double >::type azimuth(azimuthSEXP);
     Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
     Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
     Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
     Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_altitudes_for_azimuth_cpp(dem, azimuth, gridConvergence, resolution, correctCurvature, incFactor));
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< std::string >::type quantize(quantizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type grainSize(grainSizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type ranges(rangesSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_altitudes_for_azimuth_cpp(dem, azimuth, gridConvergence, resolution, correctCurvature, incFactor, method, quantize, prune, correctRefraction, altitudeCaps, stats, numThreads, grainSize, ranges));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_altitudes_for_azimuths_cpp
+SEXP get_altitudes_for_azimuths_cpp(SEXP dem, double azimuthMin, double azimuthMax, double azimuthStep, double gridConvergence, double resolution, bool correctCurvature, double incFactor, std::string method, std::string quantize, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, bool stats, int numThreads, int grainSize, Rcpp::Nullable<List> farField, bool ranges);
+RcppExport SEXP _sunlightRCPP_get_altitudes_for_azimuths_cpp(SEXP demSEXP, SEXP azimuthMinSEXP, SEXP azimuthMaxSEXP, SEXP azimuthStepSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP methodSEXP, SEXP quantizeSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP statsSEXP, SEXP numThreadsSEXP, SEXP grainSizeSEXP, SEXP farFieldSEXP, SEXP rangesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMin(azimuthMinSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMax(azimuthMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthStep(azimuthStepSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< std::string >::type quantize(quantizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type grainSize(grainSizeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<List> >::type farField(farFieldSEXP);
+    Rcpp::traits::input_parameter< bool >::type ranges(rangesSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_altitudes_for_azimuths_cpp(dem, azimuthMin, azimuthMax, azimuthStep, gridConvergence, resolution, correctCurvature, incFactor, method, quantize, prune, correctRefraction, altitudeCaps, stats, numThreads, grainSize, farField, ranges));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_altitudes_store_cpp
+double write_altitudes_store_cpp(SEXP dem, std::string path, double azimuthMin, double azimuthMax, double azimuthStep, double gridConvergence, double resolution, bool correctCurvature, double incFactor, NumericVector georeference, std::string method, std::string quantize, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, int numThreads, int grainSize, Rcpp::Nullable<List> farField);
+RcppExport SEXP _sunlightRCPP_write_altitudes_store_cpp(SEXP demSEXP, SEXP pathSEXP, SEXP azimuthMinSEXP, SEXP azimuthMaxSEXP, SEXP azimuthStepSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP georeferenceSEXP, SEXP methodSEXP, SEXP quantizeSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP numThreadsSEXP, SEXP grainSizeSEXP, SEXP farFieldSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMin(azimuthMinSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMax(azimuthMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthStep(azimuthStepSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type georeference(georeferenceSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< std::string >::type quantize(quantizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type grainSize(grainSizeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<List> >::type farField(farFieldSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_altitudes_store_cpp(dem, path, azimuthMin, azimuthMax, azimuthStep, gridConvergence, resolution, correctCurvature, incFactor, georeference, method, quantize, prune, correctRefraction, altitudeCaps, numThreads, grainSize, farField));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_altitudes_tiffs_cpp
+List write_altitudes_tiffs_cpp(SEXP dem, double azimuthMin, double azimuthMax, double azimuthStep, double gridConvergence, double resolution, bool correctCurvature, double incFactor, NumericVector georeference, CharacterVector paths, std::string method, std::string quantize, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, int azimuthBatch, int stripeWidth, Rcpp::Nullable<CharacterVector> stripePaths, std::string compress, int epsg, int writerThreads, int numThreads, int grainSize, Rcpp::Nullable<List> farField, bool stats);
+RcppExport SEXP _sunlightRCPP_write_altitudes_tiffs_cpp(SEXP demSEXP, SEXP azimuthMinSEXP, SEXP azimuthMaxSEXP, SEXP azimuthStepSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP georeferenceSEXP, SEXP pathsSEXP, SEXP methodSEXP, SEXP quantizeSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP azimuthBatchSEXP, SEXP stripeWidthSEXP, SEXP stripePathsSEXP, SEXP compressSEXP, SEXP epsgSEXP, SEXP writerThreadsSEXP, SEXP numThreadsSEXP, SEXP grainSizeSEXP, SEXP farFieldSEXP, SEXP statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMin(azimuthMinSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMax(azimuthMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthStep(azimuthStepSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type georeference(georeferenceSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< std::string >::type quantize(quantizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< int >::type azimuthBatch(azimuthBatchSEXP);
+    Rcpp::traits::input_parameter< int >::type stripeWidth(stripeWidthSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<CharacterVector> >::type stripePaths(stripePathsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type compress(compressSEXP);
+    Rcpp::traits::input_parameter< int >::type epsg(epsgSEXP);
+    Rcpp::traits::input_parameter< int >::type writerThreads(writerThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type grainSize(grainSizeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<List> >::type farField(farFieldSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_altitudes_tiffs_cpp(dem, azimuthMin, azimuthMax, azimuthStep, gridConvergence, resolution, correctCurvature, incFactor, georeference, paths, method, quantize, prune, correctRefraction, altitudeCaps, azimuthBatch, stripeWidth, stripePaths, compress, epsg, writerThreads, numThreads, grainSize, farField, stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// create_altitudes_store_cpp
+void create_altitudes_store_cpp(std::string path, int nrow, int ncol, double azimuthMin, double azimuthMax, double azimuthStep, NumericVector georeference, std::string quantize, Rcpp::Nullable<NumericVector> altitudeCaps);
+RcppExport SEXP _sunlightRCPP_create_altitudes_store_cpp(SEXP pathSEXP, SEXP nrowSEXP, SEXP ncolSEXP, SEXP azimuthMinSEXP, SEXP azimuthMaxSEXP, SEXP azimuthStepSEXP, SEXP georeferenceSEXP, SEXP quantizeSEXP, SEXP altitudeCapsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< int >::type nrow(nrowSEXP);
+    Rcpp::traits::input_parameter< int >::type ncol(ncolSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMin(azimuthMinSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMax(azimuthMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthStep(azimuthStepSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type georeference(georeferenceSEXP);
+    Rcpp::traits::input_parameter< std::string >::type quantize(quantizeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    create_altitudes_store_cpp(path, nrow, ncol, azimuthMin, azimuthMax, azimuthStep, georeference, quantize, altitudeCaps);
+    return R_NilValue;
+END_RCPP
+}
+// write_altitudes_store_tile_cpp
+double write_altitudes_store_tile_cpp(NumericMatrix& window, std::string path, IntegerVector tile, int firstLayer, int nLayers, double gridConvergence, double resolution, bool correctCurvature, double incFactor, std::string method, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, int numThreads, int grainSize);
+RcppExport SEXP _sunlightRCPP_write_altitudes_store_tile_cpp(SEXP windowSEXP, SEXP pathSEXP, SEXP tileSEXP, SEXP firstLayerSEXP, SEXP nLayersSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP methodSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP numThreadsSEXP, SEXP grainSizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix& >::type window(windowSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type tile(tileSEXP);
+    Rcpp::traits::input_parameter< int >::type firstLayer(firstLayerSEXP);
+    Rcpp::traits::input_parameter< int >::type nLayers(nLayersSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type grainSize(grainSizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_altitudes_store_tile_cpp(window, path, tile, firstLayer, nLayers, gridConvergence, resolution, correctCurvature, incFactor, method, prune, correctRefraction, altitudeCaps, numThreads, grainSize));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_tiles_cpp
+DataFrame get_tiles_cpp(int nrow, int ncol, int tileSize, double relief, double minSunAltitude, double resolution);
+RcppExport SEXP _sunlightRCPP_get_tiles_cpp(SEXP nrowSEXP, SEXP ncolSEXP, SEXP tileSizeSEXP, SEXP reliefSEXP, SEXP minSunAltitudeSEXP, SEXP resolutionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type nrow(nrowSEXP);
+    Rcpp::traits::input_parameter< int >::type ncol(ncolSEXP);
+    Rcpp::traits::input_parameter< int >::type tileSize(tileSizeSEXP);
+    Rcpp::traits::input_parameter< double >::type relief(reliefSEXP);
+    Rcpp::traits::input_parameter< double >::type minSunAltitude(minSunAltitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_tiles_cpp(nrow, ncol, tileSize, relief, minSunAltitude, resolution));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_dxdy_for_azimuth_cpp
-NumericVector get_dxdy_for_azimuth_cpp(NumericMatrix& dem, double azimuth, double resolution);
+NumericVector get_dxdy_for_azimuth_cpp(SEXP dem, double azimuth, double resolution);
 RcppExport SEXP _sunlightRCPP_get_dxdy_for_azimuth_cpp(SEXP demSEXP, SEXP azimuthSEXP, SEXP resolutionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
     Rcpp::traits::input_parameter< double >::type azimuth(azimuthSEXP);
     Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
     rcpp_result_gen = Rcpp::wrap(get_dxdy_for_azimuth_cpp(dem, azimuth, resolution));
     return rcpp_result_gen;
 END_RCPP
 }
+// get_horizons_for_points_cpp
+List get_horizons_for_points_cpp(SEXP dem, NumericVector x, NumericVector y, NumericVector georeference, double azimuthMin, double azimuthMax, double azimuthStep, double gridConvergence, double resolution, bool correctCurvature, double incFactor, bool prune, bool correctRefraction, Rcpp::Nullable<NumericVector> lat, Rcpp::Nullable<NumericVector> lon, double timeStart, double timeStop, double timestep, int numThreads);
+RcppExport SEXP _sunlightRCPP_get_horizons_for_points_cpp(SEXP demSEXP, SEXP xSEXP, SEXP ySEXP, SEXP georeferenceSEXP, SEXP azimuthMinSEXP, SEXP azimuthMaxSEXP, SEXP azimuthStepSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP pruneSEXP, SEXP correctRefractionSEXP, SEXP latSEXP, SEXP lonSEXP, SEXP timeStartSEXP, SEXP timeStopSEXP, SEXP timestepSEXP, SEXP numThreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type georeference(georeferenceSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMin(azimuthMinSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthMax(azimuthMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthStep(azimuthStepSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< bool >::type prune(pruneSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type lon(lonSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStart(timeStartSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStop(timeStopSEXP);
+    Rcpp::traits::input_parameter< double >::type timestep(timestepSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_horizons_for_points_cpp(dem, x, y, georeference, azimuthMin, azimuthMax, azimuthStep, gridConvergence, resolution, correctCurvature, incFactor, prune, correctRefraction, lat, lon, timeStart, timeStop, timestep, numThreads));
+    return rcpp_result_gen;
+END_RCPP
+}
 // get_shades_for_altitudes_cpp
-NumericMatrix get_shades_for_altitudes_cpp(NumericMatrix& altitudes, double minAltitude);
-RcppExport SEXP _sunlightRCPP_get_shades_for_altitudes_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP) {
+SEXP get_shades_for_altitudes_cpp(SEXP altitudes, double minAltitude, bool packed);
+RcppExport SEXP _sunlightRCPP_get_shades_for_altitudes_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP, SEXP packedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
     Rcpp::traits::input_parameter< double >::type minAltitude(minAltitudeSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_shades_for_altitudes_cpp(altitudes, minAltitude));
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_shades_for_altitudes_cpp(altitudes, minAltitude, packed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_mask_layer_cpp
+NumericMatrix get_mask_layer_cpp(RawVector mask, int index);
+RcppExport SEXP _sunlightRCPP_get_mask_layer_cpp(SEXP maskSEXP, SEXP indexSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< RawVector >::type mask(maskSEXP);
+    Rcpp::traits::input_parameter< int >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_mask_layer_cpp(mask, index));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_shades_for_points_cpp
+LogicalMatrix get_shades_for_points_cpp(std::string path, NumericVector x, NumericVector y, NumericVector lat, NumericVector lon, NumericVector times, bool correctRefraction);
+RcppExport SEXP _sunlightRCPP_get_shades_for_points_cpp(SEXP pathSEXP, SEXP xSEXP, SEXP ySEXP, SEXP latSEXP, SEXP lonSEXP, SEXP timesSEXP, SEXP correctRefractionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lon(lonSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type times(timesSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_shades_for_points_cpp(path, x, y, lat, lon, times, correctRefraction));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_sunlight_duration_for_points_cpp
+NumericVector get_sunlight_duration_for_points_cpp(std::string path, NumericVector x, NumericVector y, NumericVector lat, NumericVector lon, double timeStart, double timeStop, double timestep, bool correctRefraction);
+RcppExport SEXP _sunlightRCPP_get_sunlight_duration_for_points_cpp(SEXP pathSEXP, SEXP xSEXP, SEXP ySEXP, SEXP latSEXP, SEXP lonSEXP, SEXP timeStartSEXP, SEXP timeStopSEXP, SEXP timestepSEXP, SEXP correctRefractionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lon(lonSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStart(timeStartSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStop(timeStopSEXP);
+    Rcpp::traits::input_parameter< double >::type timestep(timestepSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_duration_for_points_cpp(path, x, y, lat, lon, timeStart, timeStop, timestep, correctRefraction));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_shades_for_sun_position_cpp
+SEXP get_shades_for_sun_position_cpp(SEXP dem, double azimuth, double altitude, double gridConvergence, double resolution, bool sunlight, bool packed, int numThreads);
+RcppExport SEXP _sunlightRCPP_get_shades_for_sun_position_cpp(SEXP demSEXP, SEXP azimuthSEXP, SEXP altitudeSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP sunlightSEXP, SEXP packedSEXP, SEXP numThreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuth(azimuthSEXP);
+    Rcpp::traits::input_parameter< double >::type altitude(altitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type sunlight(sunlightSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_shades_for_sun_position_cpp(dem, azimuth, altitude, gridConvergence, resolution, sunlight, packed, numThreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_sun_positions_cpp
+DataFrame get_sun_positions_cpp(NumericVector times, double lat, double lon, bool correctRefraction);
+RcppExport SEXP _sunlightRCPP_get_sun_positions_cpp(SEXP timesSEXP, SEXP latSEXP, SEXP lonSEXP, SEXP correctRefractionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type times(timesSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type lon(lonSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sun_positions_cpp(times, lat, lon, correctRefraction));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_sunlight_times_cpp
+DataFrame get_sunlight_times_cpp(NumericVector dates, double lat, double lon);
+RcppExport SEXP _sunlightRCPP_get_sunlight_times_cpp(SEXP datesSEXP, SEXP latSEXP, SEXP lonSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type dates(datesSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type lon(lonSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_times_cpp(dates, lat, lon));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_max_sun_altitudes_cpp
+NumericVector get_max_sun_altitudes_cpp(NumericVector azimuths, double lat, double azimuthWidth, bool correctRefraction);
+RcppExport SEXP _sunlightRCPP_get_max_sun_altitudes_cpp(SEXP azimuthsSEXP, SEXP latSEXP, SEXP azimuthWidthSEXP, SEXP correctRefractionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type azimuths(azimuthsSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type azimuthWidth(azimuthWidthSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_max_sun_altitudes_cpp(azimuths, lat, azimuthWidth, correctRefraction));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_sunlight_duration_for_altitudes_cpp
+NumericMatrix get_sunlight_duration_for_altitudes_cpp(SEXP altitudes, IntegerVector layers, NumericVector sunAltitudes, NumericVector weights, Rcpp::Nullable<NumericMatrix> durations);
+RcppExport SEXP _sunlightRCPP_get_sunlight_duration_for_altitudes_cpp(SEXP altitudesSEXP, SEXP layersSEXP, SEXP sunAltitudesSEXP, SEXP weightsSEXP, SEXP durationsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type layers(layersSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type sunAltitudes(sunAltitudesSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericMatrix> >::type durations(durationsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_duration_for_altitudes_cpp(altitudes, layers, sunAltitudes, weights, durations));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_sunlight_duration_for_period_cpp
+NumericMatrix get_sunlight_duration_for_period_cpp(SEXP altitudes, double timeStart, double timeStop, double timestep, double lat, double lon);
+RcppExport SEXP _sunlightRCPP_get_sunlight_duration_for_period_cpp(SEXP altitudesSEXP, SEXP timeStartSEXP, SEXP timeStopSEXP, SEXP timestepSEXP, SEXP latSEXP, SEXP lonSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStart(timeStartSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStop(timeStopSEXP);
+    Rcpp::traits::input_parameter< double >::type timestep(timestepSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type lon(lonSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_duration_for_period_cpp(altitudes, timeStart, timeStop, timestep, lat, lon));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_shade_masks_for_period_cpp
+RawVector get_shade_masks_for_period_cpp(SEXP altitudes, double timeStart, double timeStop, double timestep, double lat, double lon, bool sunlight);
+RcppExport SEXP _sunlightRCPP_get_shade_masks_for_period_cpp(SEXP altitudesSEXP, SEXP timeStartSEXP, SEXP timeStopSEXP, SEXP timestepSEXP, SEXP latSEXP, SEXP lonSEXP, SEXP sunlightSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStart(timeStartSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStop(timeStopSEXP);
+    Rcpp::traits::input_parameter< double >::type timestep(timestepSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type lon(lonSEXP);
+    Rcpp::traits::input_parameter< bool >::type sunlight(sunlightSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_shade_masks_for_period_cpp(altitudes, timeStart, timeStop, timestep, lat, lon, sunlight));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_duration_for_masks_cpp
+NumericMatrix get_duration_for_masks_cpp(RawVector masks);
+RcppExport SEXP _sunlightRCPP_get_duration_for_masks_cpp(SEXP masksSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< RawVector >::type masks(masksSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_duration_for_masks_cpp(masks));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_terrain_sunlight_for_period_cpp
+List get_terrain_sunlight_for_period_cpp(SEXP altitudes, double timeStart, double timeStop, double lat, double lon);
+RcppExport SEXP _sunlightRCPP_get_terrain_sunlight_for_period_cpp(SEXP altitudesSEXP, SEXP timeStartSEXP, SEXP timeStopSEXP, SEXP latSEXP, SEXP lonSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStart(timeStartSEXP);
+    Rcpp::traits::input_parameter< double >::type timeStop(timeStopSEXP);
+    Rcpp::traits::input_parameter< double >::type lat(latSEXP);
+    Rcpp::traits::input_parameter< double >::type lon(lonSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_terrain_sunlight_for_period_cpp(altitudes, timeStart, timeStop, lat, lon));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_sunlight_for_altitudes_cpp
-NumericMatrix get_sunlight_for_altitudes_cpp(NumericMatrix& altitudes, double minAltitude);
-RcppExport SEXP _sunlightRCPP_get_sunlight_for_altitudes_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP) {
+SEXP get_sunlight_for_altitudes_cpp(SEXP altitudes, double minAltitude, bool packed);
+RcppExport SEXP _sunlightRCPP_get_sunlight_for_altitudes_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP, SEXP packedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
     Rcpp::traits::input_parameter< double >::type minAltitude(minAltitudeSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_sunlight_for_altitudes_cpp(altitudes, minAltitude));
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_for_altitudes_cpp(altitudes, minAltitude, packed));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_sunlight_for_altitudes_p_cpp
-NumericMatrix get_sunlight_for_altitudes_p_cpp(NumericMatrix& altitudes, double minAltitude);
-RcppExport SEXP _sunlightRCPP_get_sunlight_for_altitudes_p_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP) {
+SEXP get_sunlight_for_altitudes_p_cpp(SEXP altitudes, double minAltitude, bool packed);
+RcppExport SEXP _sunlightRCPP_get_sunlight_for_altitudes_p_cpp(SEXP altitudesSEXP, SEXP minAltitudeSEXP, SEXP packedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericMatrix& >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
     Rcpp::traits::input_parameter< double >::type minAltitude(minAltitudeSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_sunlight_for_altitudes_p_cpp(altitudes, minAltitude));
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_sunlight_for_altitudes_p_cpp(altitudes, minAltitude, packed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// update_altitudes_for_azimuths_cpp
+SEXP update_altitudes_for_azimuths_cpp(NumericMatrix& dem, SEXP altitudes, IntegerVector box, double previousMax, double gridConvergence, double resolution, bool correctCurvature, double incFactor, std::string method, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, Rcpp::Nullable<List> farField);
+RcppExport SEXP _sunlightRCPP_update_altitudes_for_azimuths_cpp(SEXP demSEXP, SEXP altitudesSEXP, SEXP boxSEXP, SEXP previousMaxSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP methodSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP farFieldSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type altitudes(altitudesSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type box(boxSEXP);
+    Rcpp::traits::input_parameter< double >::type previousMax(previousMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<List> >::type farField(farFieldSEXP);
+    rcpp_result_gen = Rcpp::wrap(update_altitudes_for_azimuths_cpp(dem, altitudes, box, previousMax, gridConvergence, resolution, correctCurvature, incFactor, method, correctRefraction, altitudeCaps, farField));
+    return rcpp_result_gen;
+END_RCPP
+}
+// update_altitudes_store_cpp
+double update_altitudes_store_cpp(NumericMatrix& dem, std::string path, IntegerVector box, double previousMax, double gridConvergence, double resolution, bool correctCurvature, double incFactor, std::string method, bool correctRefraction, Rcpp::Nullable<NumericVector> altitudeCaps, Rcpp::Nullable<List> farField);
+RcppExport SEXP _sunlightRCPP_update_altitudes_store_cpp(SEXP demSEXP, SEXP pathSEXP, SEXP boxSEXP, SEXP previousMaxSEXP, SEXP gridConvergenceSEXP, SEXP resolutionSEXP, SEXP correctCurvatureSEXP, SEXP incFactorSEXP, SEXP methodSEXP, SEXP correctRefractionSEXP, SEXP altitudeCapsSEXP, SEXP farFieldSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix& >::type dem(demSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type box(boxSEXP);
+    Rcpp::traits::input_parameter< double >::type previousMax(previousMaxSEXP);
+    Rcpp::traits::input_parameter< double >::type gridConvergence(gridConvergenceSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctCurvature(correctCurvatureSEXP);
+    Rcpp::traits::input_parameter< double >::type incFactor(incFactorSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< bool >::type correctRefraction(correctRefractionSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<NumericVector> >::type altitudeCaps(altitudeCapsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<List> >::type farField(farFieldSEXP);
+    rcpp_result_gen = Rcpp::wrap(update_altitudes_store_cpp(dem, path, box, previousMax, gridConvergence, resolution, correctCurvature, incFactor, method, correctRefraction, altitudeCaps, farField));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_sunlightRCPP_dem_session_cpp", (DL_FUNC) &_sunlightRCPP_dem_session_cpp, 2},
+    {"_sunlightRCPP_dem_session_info_cpp", (DL_FUNC) &_sunlightRCPP_dem_session_info_cpp, 1},
     {"_sunlightRCPP_get_altitude_distances_for_azimuth_cpp", (DL_FUNC) &_sunlightRCPP_get_altitude_distances_for_azimuth_cpp, 6},
-    {"_sunlightRCPP_get_altitudes_for_azimuth_cpp", (DL_FUNC) &_sunlightRCPP_get_altitudes_for_azimuth_cpp, 6},
+    {"_sunlightRCPP_get_altitudes_for_azimuth_cpp", (DL_FUNC) &_sunlightRCPP_get_altitudes_for_azimuth_cpp, 15},
+    {"_sunlightRCPP_get_altitudes_for_azimuths_cpp", (DL_FUNC) &_sunlightRCPP_get_altitudes_for_azimuths_cpp, 18},
+    {"_sunlightRCPP_write_altitudes_store_cpp", (DL_FUNC) &_sunlightRCPP_write_altitudes_store_cpp, 18},
+    {"_sunlightRCPP_write_altitudes_tiffs_cpp", (DL_FUNC) &_sunlightRCPP_write_altitudes_tiffs_cpp, 25},
+    {"_sunlightRCPP_create_altitudes_store_cpp", (DL_FUNC) &_sunlightRCPP_create_altitudes_store_cpp, 9},
+    {"_sunlightRCPP_write_altitudes_store_tile_cpp", (DL_FUNC) &_sunlightRCPP_write_altitudes_store_tile_cpp, 15},
+    {"_sunlightRCPP_get_tiles_cpp", (DL_FUNC) &_sunlightRCPP_get_tiles_cpp, 6},
     {"_sunlightRCPP_get_dxdy_for_azimuth_cpp", (DL_FUNC) &_sunlightRCPP_get_dxdy_for_azimuth_cpp, 3},
-    {"_sunlightRCPP_get_shades_for_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_shades_for_altitudes_cpp, 2},
-    {"_sunlightRCPP_get_sunlight_for_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_for_altitudes_cpp, 2},
-    {"_sunlightRCPP_get_sunlight_for_altitudes_p_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_for_altitudes_p_cpp, 2},
+    {"_sunlightRCPP_get_horizons_for_points_cpp", (DL_FUNC) &_sunlightRCPP_get_horizons_for_points_cpp, 19},
+    {"_sunlightRCPP_get_shades_for_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_shades_for_altitudes_cpp, 3},
+    {"_sunlightRCPP_get_mask_layer_cpp", (DL_FUNC) &_sunlightRCPP_get_mask_layer_cpp, 2},
+    {"_sunlightRCPP_get_shades_for_points_cpp", (DL_FUNC) &_sunlightRCPP_get_shades_for_points_cpp, 7},
+    {"_sunlightRCPP_get_sunlight_duration_for_points_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_duration_for_points_cpp, 9},
+    {"_sunlightRCPP_get_shades_for_sun_position_cpp", (DL_FUNC) &_sunlightRCPP_get_shades_for_sun_position_cpp, 8},
+    {"_sunlightRCPP_get_sun_positions_cpp", (DL_FUNC) &_sunlightRCPP_get_sun_positions_cpp, 4},
+    {"_sunlightRCPP_get_sunlight_times_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_times_cpp, 3},
+    {"_sunlightRCPP_get_max_sun_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_max_sun_altitudes_cpp, 4},
+    {"_sunlightRCPP_get_sunlight_duration_for_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_duration_for_altitudes_cpp, 5},
+    {"_sunlightRCPP_get_sunlight_duration_for_period_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_duration_for_period_cpp, 6},
+    {"_sunlightRCPP_get_shade_masks_for_period_cpp", (DL_FUNC) &_sunlightRCPP_get_shade_masks_for_period_cpp, 7},
+    {"_sunlightRCPP_get_duration_for_masks_cpp", (DL_FUNC) &_sunlightRCPP_get_duration_for_masks_cpp, 1},
+    {"_sunlightRCPP_get_terrain_sunlight_for_period_cpp", (DL_FUNC) &_sunlightRCPP_get_terrain_sunlight_for_period_cpp, 5},
+    {"_sunlightRCPP_get_sunlight_for_altitudes_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_for_altitudes_cpp, 3},
+    {"_sunlightRCPP_get_sunlight_for_altitudes_p_cpp", (DL_FUNC) &_sunlightRCPP_get_sunlight_for_altitudes_p_cpp, 3},
+    {"_sunlightRCPP_update_altitudes_for_azimuths_cpp", (DL_FUNC) &_sunlightRCPP_update_altitudes_for_azimuths_cpp, 12},
+    {"_sunlightRCPP_update_altitudes_store_cpp", (DL_FUNC) &_sunlightRCPP_update_altitudes_store_cpp, 12},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,40 @@
+#include "sunlight_rcpp.h"
+
+using namespace Rcpp;
+
+// a dem session: the dem copied into C++ once, with its highest elevation
+// and, with prune, its pyramid of block maxima, for the kernels taking a dem
+// (get_altitudes_for_azimuths_cpp, get_horizons_for_points_cpp, ...) to run
+// on call after call without converting or scanning it again. an external
+// pointer of class dem_session, freed with the R object
+//' @export
+// [[Rcpp::export]]
+SEXP dem_session_cpp(
+    NumericMatrix& dem,
+    bool prune = true
+  ) {
+  XPtr<sunlight::DemSession> session(new sunlight::DemSession(dem.begin(), dem.nrow(), dem.ncol()), true);
+  session->prepare(prune);
+  session.attr("class") = "dem_session";
+  return session;
+}
+
+// nrow, ncol and highest elevation of a dem session, and whether its
+// pyramid is built yet
+//' @export
+// [[Rcpp::export]]
+List dem_session_info_cpp(
+    SEXP session
+  ) {
+  DemArgument dem(session);
+  const sunlight::DemSummary* summary = dem.summary(false);
+  if (summary == NULL) {
+    Rcpp::stop("not a dem session");
+  }
+  return List::create(
+    _["nrow"] = dem.nrow(),
+    _["ncol"] = dem.ncol(),
+    _["max_elevation"] = summary->maxElev,
+    _["pyramid"] = (bool)summary->pyramid
+  );
+}
@@ -1,198 +1,771 @@
 // [[Rcpp::depends(RcppParallel)]]
-#include <RcppParallel.h>
-#include <Rcpp.h>
+#include "sunlight_rcpp.h"
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <string>
+#include <sunlight/pipeline.h>
+#include <sunlight/store.h>
+#include <sunlight/tiff.h>
+#include <utility>
+#include <vector>
 
 using namespace Rcpp;
 using namespace RcppParallel;
 
-// modulo but for doubles
-// scribed from https://stackoverflow.com/a/53998265
-double dmod(double x, double y) {
-  return x - (int)(x/y) * y;
-}
+// wall time of the phases of a run in seconds, and the counters of its
+// threads
+struct AltitudeStats {
+  double conversion; // output allocation
+  double max; // dem maximum, pyramid and transect templates
+  double traverse;
+  double output; // attributes of the result
+  sunlight::RunStats threads;
 
-double deg2rad(double deg) {
-  return deg / 180 * M_PI;
-}
+  AltitudeStats() :
+    conversion(0),
+    max(0),
+    traverse(0),
+    output(0) {}
+};
 
-double rad2deg(double rad) {
-  return rad * 180 / M_PI;
+// the stats attribute of a result: phase times, counters over all threads
+// and a data frame of the counters and busy time of each thread
+List altitudeStatsList(const AltitudeStats& stats) {
+  int nThreads = stats.threads.threads();
+  NumericVector tasks(nThreads), steps(nThreads), earlyBreaks(nThreads), edgeExits(nThreads), naCells(nThreads), busy(nThreads);
+  for (int t = 0; t < nThreads; t++) {
+    const sunlight::RunStats::Slot& slot = stats.threads.slot(t);
+    tasks[t] = slot.tasks;
+    steps[t] = slot.steps;
+    earlyBreaks[t] = slot.earlyBreaks;
+    edgeExits[t] = slot.edgeExits;
+    naCells[t] = slot.naCells;
+    busy[t] = slot.busyNanoseconds / 1e9;
+  }
+  sunlight::SearchCounters total = stats.threads.total();
+  NumericVector phases = NumericVector::create(
+    _["conversion"] = stats.conversion,
+    _["max"] = stats.max,
+    _["traverse"] = stats.traverse,
+    _["output"] = stats.output
+  );
+  return List::create(
+    _["phases"] = phases,
+    _["steps"] = (double)total.steps,
+    _["skipped_steps"] = (double)total.skipped,
+    _["early_breaks"] = (double)total.earlyBreaks,
+    _["edge_exits"] = (double)total.edgeExits,
+    _["na_cells"] = (double)total.naCells,
+    _["threads"] = DataFrame::create(
+      _["tasks"] = tasks,
+      _["steps"] = steps,
+      _["early_breaks"] = earlyBreaks,
+      _["edge_exits"] = edgeExits,
+      _["na_cells"] = naCells,
+      _["busy_seconds"] = busy
+    )
+  );
 }
 
-double getCurvatureCorrection(double distance) {
-  // util
-  int radiusEarth = 6371000; // in m
-  // 2 * M_PI * radiusEarth;
-  double anglePerUnit = 0.000009;
-  // 360 / circumferenceEarth;
-  double totalAngle = anglePerUnit * distance; //  Unit degrees * distance
-  return radiusEarth * (1 - cos(deg2rad(totalAngle)));
+// run the core altitude job for all azimuths on dem into output, returning the
+// number of transect samples skipped by pruning. a dem session brings its
+// maximum and pyramid, a matrix has them derived for this run. altitudeCaps
+// are the sun envelope caps per azimuth, or empty. the job runs on numThreads
+// threads (-1 for all) in blocks of about grainSize cells (0 for the default,
+// see sunlight::WorkBlock). stats, if not NULL, gets the time of the max and
+// traverse phases and the counters of every thread. with far fields, not
+// NULL or empty, the transects end at their reach and go on in them
+template <typename T>
+double computeAltitudes(
+    const DemArgument& dem,
+    const std::vector<double>& azimuths,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    bool correctRefraction,
+    double incFactor,
+    const std::string& method,
+    bool prune,
+    const std::vector<double>& altitudeCaps,
+    int numThreads,
+    int grainSize,
+    T* output,
+    AltitudeStats* stats = NULL,
+    const FarFieldArgument* farField = NULL
+  ) {
+  double start = sunlight::stopwatch();
+  sunlight::Method parsed = sunlight::parseMethod(method);
+  sunlight::AltitudeJob<double, T> job(
+      dem.view(),
+      output,
+      azimuths,
+      gridConvergence,
+      resolution,
+      incFactor,
+      parsed,
+      prune,
+      correctCurvature,
+      correctRefraction,
+      altitudeCaps,
+      dem.summary(prune && parsed == sunlight::MARCH),
+      farField ? farField->reach() : INFINITY
+  );
+  if (job.effectiveMethod() != parsed) {
+    Rcpp::warning("sweep does not support curvature correction, using lines with incFactor 1");
+  }
+  job.setGrainSize(grainSize);
+  double prepared = sunlight::stopwatch();
+  if (stats) {
+    job.collectStats(&stats->threads);
+  }
+  runJob(job, numThreads);
+  if (farField && !farField->empty()) {
+    sunlight::FarFieldJob<double, T> far(
+        dem.view(),
+        farField->georeference,
+        farField->fields,
+        output,
+        azimuths,
+        gridConvergence,
+        incFactor,
+        correctCurvature,
+        correctRefraction,
+        altitudeCaps
+    );
+    runJob(far, numThreads);
+  }
+  if (stats) {
+    stats->max += prepared - start;
+    stats->traverse += sunlight::stopwatch() - prepared;
+  }
+  return job.skippedSteps();
 }
 
-struct ParallelWorker : public Worker {
-  const NumericMatrix& input_dem;
-  Rcpp::NumericMatrix output_matrix;
-  const double dx;
-  const double dy;
-  const double dxy;
-  const int height;
-  const int width;
-  const double maxElev;
-  const double inc_factor;
-
-  ParallelWorker(
-    const NumericMatrix& input,
-    Rcpp::NumericMatrix output,
-    const double dx,
-    const double dy,
-    const double dxy,
-    const int height,
-    const int width,
-    const double maxElev,
-    const double inc_factor
-  ) :
-    input_dem(input),
-    output_matrix(output),
-    dx(dx),
-    dy(dy),
-    dxy(dxy),
-    height(height),
-    width(width),
-    maxElev(maxElev),
-    inc_factor(inc_factor) {}
-
-  void operator()(std::size_t begin, std::size_t end) {
-    for (std::size_t col = begin; col < end; col++) {
-      for(int row = 0; row < height; row++) {
-        double elevationOrigin = input_dem(row, col);
-        double altitudeMin = 0;
-        if (!NumericVector::is_na(elevationOrigin)) {
-          // calculate maximum possible difference in elevation
-          int step = 0;
-          int stepFactor = 0;
-          // traverse transect to find max altitude difference
-          while (true) {
-            stepFactor = step + pow(inc_factor, step + 1) ;
-            step++;
-            // stepFactor = step;
-            double distanceStep = dxy * stepFactor;
-            int rowStep = row + round(dy * stepFactor);
-            int colStep = col + round(dx * stepFactor);
-            if (rowStep >= 0 && rowStep < height && colStep >= 0 && colStep < width) {
-              double elevStep = input_dem(rowStep, colStep);
-              double elevDiffStep = elevStep - elevationOrigin;
-              if (elevDiffStep > 0) {
-                if (elevDiffStep > 0) {
-                  // calculate angle
-                  double altitudeStep = rad2deg(atan(elevDiffStep / distanceStep));
-                  if (altitudeStep > altitudeMin) {
-                    altitudeMin = altitudeStep;
-                  } else {
-                    // check if higher altitude is feasible
-                    double elevationMaxDiff = maxElev - elevationOrigin;
-                    double altitudeMax = rad2deg(atan(elevationMaxDiff / distanceStep));
-                    if (altitudeMax < altitudeMin) {
-                      break;
-                    }
-                  }
-                }
-              }
-            } else {
-              // break if out of bounds
-              break;
-            }
-          }
-        }
-        output_matrix(row, col) = altitudeMin;
-      }
+// allocate the output with dimensions dim, storing angles as doubles or as
+// quantized counts (quantize: "none", "uint16" or "uint8"), and compute it.
+// the skipped transect samples are kept as attribute skipped_steps, stats
+// gets the phase times and thread counters if not NULL, far fields as for
+// computeAltitudes. withRanges adds the horizon ranges per tile of each
+// layer as attribute horizon_ranges (see horizonRangesList)
+SEXP altitudesOutput(
+    const DemArgument& dem,
+    const std::vector<double>& azimuths,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    bool correctRefraction,
+    double incFactor,
+    const std::string& method,
+    const std::string& quantize,
+    bool prune,
+    const std::vector<double>& altitudeCaps,
+    int numThreads,
+    int grainSize,
+    IntegerVector dim,
+    AltitudeStats* stats = NULL,
+    const FarFieldArgument* farField = NULL,
+    bool withRanges = false
+  ) {
+  int nLayers = azimuths.size();
+  std::size_t n = (std::size_t)azimuths.size() * dem.nrow() * dem.ncol();
+  double start = sunlight::stopwatch();
+  if (quantize == "uint16") {
+    RawVector counts = allocateQuantized<uint16_t>(n, dim);
+    if (stats) {
+      stats->conversion += sunlight::stopwatch() - start;
     }
+    counts.attr("skipped_steps") = computeAltitudes(dem, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, altitudeCaps, numThreads, grainSize, quantizedData<uint16_t>(counts), stats, farField);
+    if (withRanges) {
+      counts.attr("horizon_ranges") = horizonRangesList(quantizedData<uint16_t>(counts), nLayers, dem.nrow(), dem.ncol(), 1, nLayers);
+    }
+    return counts;
+  } else if (quantize == "uint8") {
+    RawVector counts = allocateQuantized<uint8_t>(n, dim);
+    if (stats) {
+      stats->conversion += sunlight::stopwatch() - start;
+    }
+    counts.attr("skipped_steps") = computeAltitudes(dem, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, altitudeCaps, numThreads, grainSize, quantizedData<uint8_t>(counts), stats, farField);
+    if (withRanges) {
+      counts.attr("horizon_ranges") = horizonRangesList(quantizedData<uint8_t>(counts), nLayers, dem.nrow(), dem.ncol(), 1, nLayers);
+    }
+    return counts;
+  } else if (quantize != "none") {
+    Rcpp::stop("unknown quantize: " + quantize);
   }
-};
-
+  NumericVector altitudes(n);
+  altitudes.attr("dim") = dim;
+  if (stats) {
+    stats->conversion += sunlight::stopwatch() - start;
+  }
+  altitudes.attr("skipped_steps") = computeAltitudes(dem, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, altitudeCaps, numThreads, grainSize, altitudes.begin(), stats, farField);
+  if (withRanges) {
+    altitudes.attr("horizon_ranges") = horizonRangesList<double>(altitudes.begin(), nLayers, dem.nrow(), dem.ncol(), 1, nLayers);
+  }
+  return altitudes;
+}
 
 //' @export
 // [[Rcpp::export]]
-NumericMatrix get_altitudes_for_azimuth_cpp(
-    NumericMatrix& dem,
+SEXP get_altitudes_for_azimuth_cpp(
+    SEXP dem,
     double azimuth,
     double gridConvergence,
     double resolution,
     bool correctCurvature,
-    double incFactor
+    double incFactor,
+    std::string method = "march",
+    std::string quantize = "none",
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    bool stats = false,
+    int numThreads = -1,
+    int grainSize = 0,
+    bool ranges = false
   ) {
-  Rprintf("get_altitudes_for_azimuth_cpp (%f) \n", azimuth);
-  // figure out row and column offset dx, dy for azimuth
-  double azi = dmod((azimuth + gridConvergence), 360);
-  // steps x and y as factor
-  double dx = 1;
-  double dy = 1;
-  // figure out effective angle for step calculation
-  double aziRel = dmod(azi,90);
-  if (aziRel > 45) {
-    aziRel = 90 - aziRel;
-  }
-  double dopp = tan(deg2rad(aziRel));
-
-  // NNE
-  if (azi <= 45) {
-    dx = dopp;
-    dy = -1;
-  // NEE
-  } else if ((azi > 45) & (azi <= 90)) {
-    //    dx = 1;
-    dy = dopp * -1;
-  // SEE
-  } else if ((azi > 90) & (azi <= 135)) {
-    //  dx = 1;
-    dy = dopp;
-  // SSE
-  } else if ((azi > 135) & (azi <= 180)) {
-    dx = dopp;
-    // dy = 1;
-  // SSW
-  } else if  ((azi > 180) & (azi <= 225)) {
-    dx = dopp * -1;
-    // dy = 1;
-  // SWW
-  } else if  ((azi > 225) & (azi <= 270)) {
-    dx = -1;
-    dy = dopp;
-  // NWW
-  } else if  ((azi > 270) & (azi <= 315)) {
-    dx = -1;
-    dy = dopp * -1;
-  // NNW
-  } else if (azi > 315) {
-    dx = dopp * -1;
-    dy = -1;
-  }
-
-  // dxy = distance of sampling steps in m
-  double dxy = sqrt(pow(dx, 2) + pow(dy, 2)) * resolution;
+  // remember shape
+  DemArgument input(dem);
+  int width = input.ncol();
+  int height = input.nrow();
+  // parallelise blocks of columns (march) or lines (lines, sweep)
+  AltitudeStats runStats;
+  RObject minAltitudeMatrix = altitudesOutput(
+    input,
+    std::vector<double>(1, azimuth),
+    gridConvergence,
+    resolution,
+    correctCurvature,
+    correctRefraction,
+    incFactor,
+    method,
+    quantize,
+    prune,
+    altitudeCapsOf(altitudeCaps, 1),
+    numThreads,
+    grainSize,
+    IntegerVector::create(height, width),
+    stats ? &runStats : NULL,
+    NULL,
+    ranges
+  );
+  if (stats) {
+    minAltitudeMatrix.attr("stats") = altitudeStatsList(runStats);
+  }
+  return minAltitudeMatrix;
+}
 
+// horizon cube for azimuthMin, azimuthMin + azimuthStep, ..., azimuthMax with
+// dim (azimuth, row, col) and attributes azimuths and azimuth_step. dem is a
+// matrix, scanned once per call, or a session of dem_session_cpp, scanned once
+// for all calls. with altitudeCaps, the highest sun altitude per azimuth
+// (get_max_sun_altitudes_cpp), cells whose horizon passes the cap stop
+// searching and store 90, never sunlit from there; the caps are kept as
+// attribute altitude_caps. with stats, attribute stats holds the wall time of
+// the phases conversion, max, traverse and output, the transect steps, early
+// breaks, grid edge exits and NA cells of the run and the same counters with
+// tasks and busy time per thread. the run is cut into blocks of about
+// grainSize cells (0 for the default) handed out heaviest first to numThreads
+// threads (-1 for all). farField, list(georeference, dems, georeferences,
+// distances), adds coarser dems over a larger extent: transects switch to
+// them from their distances on (march and lines; sweep reads the whole dem
+// and the far fields only add to it); the first distance is kept as
+// attribute far_field_reach for updates. with ranges, attribute
+// horizon_ranges holds the lowest and highest horizon of each 64 x 64 tile
+// per azimuth, which the shade, sunlight and duration kernels use to fill
+// whole tiles
+//' @export
+// [[Rcpp::export]]
+SEXP get_altitudes_for_azimuths_cpp(
+    SEXP dem,
+    double azimuthMin,
+    double azimuthMax,
+    double azimuthStep,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    std::string method = "march",
+    std::string quantize = "none",
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    bool stats = false,
+    int numThreads = -1,
+    int grainSize = 0,
+    Rcpp::Nullable<List> farField = R_NilValue,
+    bool ranges = false
+  ) {
+  std::vector<double> azimuths = azimuthRange(azimuthMin, azimuthMax, azimuthStep);
+  int nAzimuths = azimuths.size();
+  std::vector<double> caps = altitudeCapsOf(altitudeCaps, nAzimuths);
+  FarFieldArgument far(farField);
   // remember shape
-  int width = dem.ncol();
-  int height = dem.nrow();
-  double maxElev = max(dem);
-  // initialize result matrix
-  Rcpp::NumericMatrix minAltitudeMatrix(height, width);
-  ParallelWorker parallelWorker(
-      dem, // input matrix
-      minAltitudeMatrix, // output matrix
-      dx,
-      dy,
-      dxy,
-      height,
-      width,
-      maxElev,
-      incFactor
+  DemArgument input(dem);
+  int width = input.ncol();
+  int height = input.nrow();
+  AltitudeStats runStats;
+  RObject cube = altitudesOutput(
+    input,
+    azimuths,
+    gridConvergence,
+    resolution,
+    correctCurvature,
+    correctRefraction,
+    incFactor,
+    method,
+    quantize,
+    prune,
+    caps,
+    numThreads,
+    grainSize,
+    IntegerVector::create(nAzimuths, height, width),
+    stats ? &runStats : NULL,
+    &far,
+    ranges
   );
-  // parallelise columns
-  Rprintf("parallelWorker start (%i) \n", width);
+  double start = sunlight::stopwatch();
+  cube.attr("azimuths") = NumericVector(azimuths.begin(), azimuths.end());
+  cube.attr("azimuth_step") = azimuthStep;
+  if (!caps.empty()) {
+    cube.attr("altitude_caps") = NumericVector(caps.begin(), caps.end());
+  }
+  if (!far.empty()) {
+    cube.attr("far_field_reach") = far.reach();
+  }
+  if (stats) {
+    runStats.output = sunlight::stopwatch() - start;
+    cube.attr("stats") = altitudeStatsList(runStats);
+  }
 
-  parallelFor(0, width, parallelWorker);
+  return cube;
+}
 
-  Rprintf("parallelWorker stop (%i) \n", width);
-  return minAltitudeMatrix;
+// header of a store for an nrow x ncol dem, georeference c(xmin, ymax, xres,
+// yres), without storage type
+sunlight::StoreHeader storeHeader(
+    int nrow,
+    int ncol,
+    const std::vector<double>& azimuths,
+    double azimuthStep,
+    NumericVector georeference
+  ) {
+  if (georeference.size() != 4) {
+    Rcpp::stop("georeference must be c(xmin, ymax, xres, yres)");
+  }
+  sunlight::StoreHeader header = sunlight::StoreHeader();
+  header.nAzimuths = azimuths.size();
+  header.nrow = nrow;
+  header.ncol = ncol;
+  header.azimuthMin = azimuths[0];
+  header.azimuthStep = azimuthStep;
+  header.xmin = georeference[0];
+  header.ymax = georeference[1];
+  header.xres = georeference[2];
+  header.yres = georeference[3];
+  return header;
+}
+
+// horizon cube as for get_altitudes_for_azimuths_cpp, computed straight into
+// a horizon store file at path (see sunlight/store.h) instead of R memory.
+// georeference is c(xmin, ymax, xres, yres) of the dem, used to find the
+// cells of queried points. the store keeps altitudeCaps for updates. far
+// fields as for get_altitudes_for_azimuths_cpp. returns the transect samples skipped by pruning; file errors surface as R
+// errors through the exported wrapper
+//' @export
+// [[Rcpp::export]]
+double write_altitudes_store_cpp(
+    SEXP dem,
+    std::string path,
+    double azimuthMin,
+    double azimuthMax,
+    double azimuthStep,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    NumericVector georeference,
+    std::string method = "march",
+    std::string quantize = "none",
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    int numThreads = -1,
+    int grainSize = 0,
+    Rcpp::Nullable<List> farField = R_NilValue
+  ) {
+  std::vector<double> azimuths = azimuthRange(azimuthMin, azimuthMax, azimuthStep);
+  DemArgument input(dem);
+  FarFieldArgument far(farField);
+  sunlight::StoreHeader header = storeHeader(input.nrow(), input.ncol(), azimuths, azimuthStep, georeference);
+  header.farReach = far.empty() ? 0 : far.reach();
+  std::vector<double> caps = altitudeCapsOf(altitudeCaps, azimuths.size());
+  if (quantize == "uint16") {
+    header.type = sunlight::StoreType<uint16_t>::id();
+    header.scale = sunlight::HorizonType<uint16_t>::scale();
+    sunlight::HorizonStore store(path, header, caps);
+    return computeAltitudes(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize, store.data<uint16_t>(), NULL, &far);
+  } else if (quantize == "uint8") {
+    header.type = sunlight::StoreType<uint8_t>::id();
+    header.scale = sunlight::HorizonType<uint8_t>::scale();
+    sunlight::HorizonStore store(path, header, caps);
+    return computeAltitudes(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize, store.data<uint8_t>(), NULL, &far);
+  } else if (quantize != "none") {
+    Rcpp::stop("unknown quantize: " + quantize);
+  }
+  header.type = sunlight::StoreType<double>::id();
+  header.scale = sunlight::HorizonType<double>::scale();
+  sunlight::HorizonStore store(path, header, caps);
+  return computeAltitudes(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize, store.data<double>(), NULL, &far);
+}
+
+// the output files of a tiff run (see write_altitudes_tiffs_cpp)
+struct TiffOutput {
+  sunlight::Georeference georeference;
+  std::vector<std::string> paths; // per azimuth, "" for none
+  int stripeWidth;
+  std::vector<std::string> stripePaths; // per azimuth and stripe
+  sunlight::TiffCompression compression;
+  int epsg;
+};
+
+// computes the azimuths in batches of azimuthBatch layers and queues the
+// files of each batch on a pipeline of writerThreads threads, which writes
+// them while the next batch computes. a batch stays in memory until its
+// files are written, the queue holds about one batch of files. stats, if not
+// NULL, sums the phases and counters over the batches, conversion being the
+// allocation of the batches and output their ranges and queueing
+template <typename T>
+List computeTiffs(
+    const DemArgument& dem,
+    const std::vector<double>& azimuths,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    bool correctRefraction,
+    double incFactor,
+    const std::string& method,
+    bool prune,
+    const std::vector<double>& altitudeCaps,
+    int azimuthBatch,
+    const TiffOutput& output,
+    int writerThreads,
+    int numThreads,
+    int grainSize,
+    const FarFieldArgument* farField,
+    AltitudeStats* stats
+  ) {
+  int nAzimuths = azimuths.size();
+  int nrow = dem.nrow();
+  int ncol = dem.ncol();
+  int nStripes = output.stripeWidth > 0 ? (ncol + output.stripeWidth - 1) / output.stripeWidth : 0;
+  sunlight::HorizonRanges<T> ranges(nrow, ncol, nAzimuths);
+  std::size_t nTiles = (std::size_t)ranges.tileRows * ranges.tileCols;
+  double skipped = 0;
+  sunlight::JobPipeline pipeline(writerThreads, (std::size_t)azimuthBatch * (1 + nStripes));
+  for (int first = 0; first < nAzimuths; first += azimuthBatch) {
+    int nBatch = std::min(azimuthBatch, nAzimuths - first);
+    std::vector<double> batch(azimuths.begin() + first, azimuths.begin() + first + nBatch);
+    std::vector<double> caps;
+    if (!altitudeCaps.empty()) {
+      caps = std::vector<double>(altitudeCaps.begin() + first, altitudeCaps.begin() + first + nBatch);
+    }
+    // shared with the writers of its files
+    double start = sunlight::stopwatch();
+    std::shared_ptr<std::vector<T> > cube(new std::vector<T>((std::size_t)nBatch * nrow * ncol));
+    if (stats) {
+      stats->conversion += sunlight::stopwatch() - start;
+    }
+    skipped += computeAltitudes(dem, batch, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize, &(*cube)[0], stats, farField);
+    start = sunlight::stopwatch();
+    sunlight::HorizonRanges<T> batchRanges(nrow, ncol, nBatch);
+    sunlight::HorizonRangeJob<T> rangeJob(&(*cube)[0], 1, nBatch, batchRanges);
+    runJob(rangeJob, numThreads);
+    for (std::size_t k = 0; k < nTiles; k++) {
+      for (int a = 0; a < nBatch; a++) {
+        ranges.mins[first + a + nAzimuths * k] = batchRanges.mins[a + nBatch * k];
+        ranges.maxs[first + a + nAzimuths * k] = batchRanges.maxs[a + nBatch * k];
+      }
+    }
+    for (int a = 0; a < nBatch; a++) {
+      std::vector<std::pair<std::string, sunlight::TiffWindow> > files;
+      if (!output.paths[first + a].empty()) {
+        sunlight::TiffWindow all = {0, 0, nrow, ncol};
+        files.push_back(std::make_pair(output.paths[first + a], all));
+      }
+      for (int i = 0; i < nStripes; i++) {
+        int col = i * output.stripeWidth;
+        sunlight::TiffWindow stripe = {0, col, nrow, std::min(ncol - col, output.stripeWidth)};
+        files.push_back(std::make_pair(output.stripePaths[(std::size_t)(first + a) * nStripes + i], stripe));
+      }
+      for (std::size_t f = 0; f < files.size(); f++) {
+        std::string path = files[f].first;
+        sunlight::TiffWindow window = files[f].second;
+        sunlight::Georeference georeference = output.georeference;
+        sunlight::TiffCompression compression = output.compression;
+        int epsg = output.epsg;
+        pipeline.push([cube, a, nBatch, nrow, path, window, georeference, compression, epsg]() {
+          sunlight::writeGeoTiff(path, &(*cube)[a], nBatch, nrow, window, georeference, epsg, compression);
+        });
+      }
+    }
+    if (stats) {
+      stats->output += sunlight::stopwatch() - start;
+    }
+    Rcpp::checkUserInterrupt();
+  }
+  pipeline.finish();
+  List result = List::create(
+    _["skipped_steps"] = skipped,
+    _["horizon_ranges"] = horizonRangesList(ranges),
+    _["write_wait"] = pipeline.waitSeconds()
+  );
+  if (stats) {
+    result["stats"] = altitudeStatsList(*stats);
+  }
+  return result;
+}
+
+// horizons for azimuthMin, azimuthMin + azimuthStep, ..., azimuthMax as for
+// get_altitudes_for_azimuths_cpp, written as tiled GeoTIFFs by background
+// threads while the next batch of azimuthBatch layers computes, without
+// passing the layers through R. georeference is c(xmin, ymax, xres, yres) of
+// the dem, epsg the code of its projected coordinate system (0 to leave it
+// out). paths holds a file per azimuth ("" for none); with stripeWidth > 0,
+// stripePaths holds the files of the stripes of stripeWidth columns of each
+// azimuth, stripes of the first azimuth first, the last stripe taking the
+// remaining columns. angles are written as FLT4S, quantized counts as INT2U
+// or INT1U, tiles compressed with compress: "deflate", "zstd" (if built
+// with zstd) or "none". returns list(skipped_steps, horizon_ranges as for
+// get_altitudes_for_azimuths_cpp, write_wait: seconds the computation waited
+// for the writers), with stats also stats as for
+// get_altitudes_for_azimuths_cpp over all batches
+//' @export
+// [[Rcpp::export]]
+List write_altitudes_tiffs_cpp(
+    SEXP dem,
+    double azimuthMin,
+    double azimuthMax,
+    double azimuthStep,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    NumericVector georeference,
+    CharacterVector paths,
+    std::string method = "march",
+    std::string quantize = "none",
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    int azimuthBatch = 10,
+    int stripeWidth = 0,
+    Rcpp::Nullable<CharacterVector> stripePaths = R_NilValue,
+    std::string compress = "deflate",
+    int epsg = 0,
+    int writerThreads = 2,
+    int numThreads = -1,
+    int grainSize = 0,
+    Rcpp::Nullable<List> farField = R_NilValue,
+    bool stats = false
+  ) {
+  std::vector<double> azimuths = azimuthRange(azimuthMin, azimuthMax, azimuthStep);
+  DemArgument input(dem);
+  FarFieldArgument far(farField);
+  std::vector<double> caps = altitudeCapsOf(altitudeCaps, azimuths.size());
+  AltitudeStats runStats;
+  if (azimuthBatch < 1) {
+    Rcpp::stop("azimuthBatch must be positive");
+  }
+  if ((std::size_t)paths.size() != azimuths.size()) {
+    Rcpp::stop("paths must have one file per azimuth");
+  }
+  TiffOutput output;
+  output.georeference = georeferenceOf(georeference);
+  output.paths = Rcpp::as<std::vector<std::string> >(paths);
+  output.stripeWidth = std::max(stripeWidth, 0);
+  if (output.stripeWidth > 0) {
+    std::size_t nStripes = (input.ncol() + output.stripeWidth - 1) / output.stripeWidth;
+    CharacterVector files = stripePaths.isNull() ? CharacterVector() : CharacterVector(stripePaths);
+    if ((std::size_t)files.size() != azimuths.size() * nStripes) {
+      Rcpp::stop("stripePaths must have one file per azimuth and stripe");
+    }
+    output.stripePaths = Rcpp::as<std::vector<std::string> >(files);
+  }
+  output.compression = sunlight::parseCompression(compress);
+  output.epsg = epsg;
+  if (quantize == "uint16") {
+    return computeTiffs<uint16_t>(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, azimuthBatch, output, writerThreads, numThreads, grainSize, &far, stats ? &runStats : NULL);
+  } else if (quantize == "uint8") {
+    return computeTiffs<uint8_t>(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, azimuthBatch, output, writerThreads, numThreads, grainSize, &far, stats ? &runStats : NULL);
+  } else if (quantize != "none") {
+    Rcpp::stop("unknown quantize: " + quantize);
+  }
+  return computeTiffs<double>(input, azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, azimuthBatch, output, writerThreads, numThreads, grainSize, &far, stats ? &runStats : NULL);
+}
+
+// empty horizon store at path for an nrow x ncol dem, to be filled tile by
+// tile with write_altitudes_store_tile_cpp, keeping altitudeCaps, the caps
+// of all its layers, if the tiles are capped
+//' @export
+// [[Rcpp::export]]
+void create_altitudes_store_cpp(
+    std::string path,
+    int nrow,
+    int ncol,
+    double azimuthMin,
+    double azimuthMax,
+    double azimuthStep,
+    NumericVector georeference,
+    std::string quantize = "none",
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue
+  ) {
+  std::vector<double> azimuths = azimuthRange(azimuthMin, azimuthMax, azimuthStep);
+  std::vector<double> caps = altitudeCapsOf(altitudeCaps, azimuths.size());
+  sunlight::StoreHeader header = storeHeader(nrow, ncol, azimuths, azimuthStep, georeference);
+  if (quantize == "uint16") {
+    header.type = sunlight::StoreType<uint16_t>::id();
+    header.scale = sunlight::HorizonType<uint16_t>::scale();
+  } else if (quantize == "uint8") {
+    header.type = sunlight::StoreType<uint8_t>::id();
+    header.scale = sunlight::HorizonType<uint8_t>::scale();
+  } else if (quantize == "none") {
+    header.type = sunlight::StoreType<double>::id();
+    header.scale = sunlight::HorizonType<double>::scale();
+  } else {
+    Rcpp::stop("unknown quantize: " + quantize);
+  }
+  sunlight::HorizonStore store(path, header, caps);
+}
+
+template <typename T>
+double computeTile(
+    NumericMatrix& window,
+    const sunlight::Tile& tile,
+    const sunlight::HorizonStore& store,
+    const std::vector<double>& azimuths,
+    int firstLayer,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    bool correctRefraction,
+    double incFactor,
+    const std::string& method,
+    bool prune,
+    const std::vector<double>& altitudeCaps,
+    int numThreads,
+    int grainSize
+  ) {
+  std::vector<T> cube((std::size_t)azimuths.size() * window.nrow() * window.ncol());
+  double skipped = computeAltitudes(DemArgument(window), azimuths, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, altitudeCaps, numThreads, grainSize, &cube[0]);
+  const sunlight::StoreHeader& header = store.getHeader();
+  sunlight::copyTileLayers(&cube[0], azimuths.size(), tile, store.data<T>(), header.nAzimuths, firstLayer, header.nrow);
+  return skipped;
+}
+
+// horizons of one tile of the store at path: window is the dem around the
+// tile, starting at the 0-based cell (windowRow, windowCol) of the store's
+// grid, and the tile's core cells (row, col, nrow, ncol, also 0-based, as
+// planned by get_tiles_cpp) get layers firstLayer..firstLayer + nLayers - 1
+// of the store, altitudeCaps holding the caps of all its layers (the caps
+// the store keeps if NULL). returns the transect samples skipped by pruning
+//' @export
+// [[Rcpp::export]]
+double write_altitudes_store_tile_cpp(
+    NumericMatrix& window,
+    std::string path,
+    IntegerVector tile,
+    int firstLayer,
+    int nLayers,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    std::string method = "march",
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    int numThreads = -1,
+    int grainSize = 0
+  ) {
+  if (tile.size() != 6) {
+    Rcpp::stop("tile must be c(row, col, nrow, ncol, windowRow, windowCol)");
+  }
+  sunlight::Tile core = {
+    tile[0], tile[1], tile[2], tile[3], tile[4], tile[5], window.nrow(), window.ncol()
+  };
+  // open the existing store writable
+  sunlight::HorizonStore store(path, true);
+  const sunlight::StoreHeader& header = store.getHeader();
+  if (firstLayer < 0 || nLayers < 1 || firstLayer + nLayers > header.nAzimuths ||
+      core.windowRow < 0 || core.windowCol < 0 ||
+      core.windowRow + core.windowNrow > header.nrow || core.windowCol + core.windowNcol > header.ncol ||
+      core.row < core.windowRow || core.col < core.windowCol ||
+      core.row + core.nrow > core.windowRow + core.windowNrow || core.col + core.ncol > core.windowCol + core.windowNcol) {
+    Rcpp::stop("tile out of range of the store");
+  }
+  std::vector<double> azimuths(nLayers);
+  for (int a = 0; a < nLayers; a++) {
+    azimuths[a] = header.azimuthMin + (firstLayer + a) * header.azimuthStep;
+  }
+  // caps are given for all layers of the store, or kept by it
+  std::vector<double> caps = altitudeCaps.isNull() ? store.altitudeCaps() : altitudeCapsOf(altitudeCaps, header.nAzimuths);
+  if (!caps.empty()) {
+    caps = std::vector<double>(caps.begin() + firstLayer, caps.begin() + firstLayer + nLayers);
+  }
+  switch (header.type) {
+  case 1:
+    return computeTile<uint16_t>(window, core, store, azimuths, firstLayer, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize);
+  case 2:
+    return computeTile<uint8_t>(window, core, store, azimuths, firstLayer, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize);
+  default:
+    return computeTile<double>(window, core, store, azimuths, firstLayer, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, prune, caps, numThreads, grainSize);
+  }
+}
+
+// tiles of at most tileSize x tileSize cells for an nrow x ncol dem, each
+// with a halo of the shadow reach of relief (m) for sun altitudes from
+// minSunAltitude (degrees) at resolution (m). one row per tile with the
+// 1-based core cells (row, col, nrow, ncol) and window
+// (window_row, window_col, window_nrow, window_ncol), for
+// raster::getValuesBlock
+//' @export
+// [[Rcpp::export]]
+DataFrame get_tiles_cpp(
+    int nrow,
+    int ncol,
+    int tileSize,
+    double relief,
+    double minSunAltitude,
+    double resolution
+  ) {
+  if (tileSize < 1) {
+    Rcpp::stop("invalid tile size");
+  }
+  int halo = sunlight::getShadowReach(relief, minSunAltitude, resolution);
+  std::vector<sunlight::Tile> tiles = sunlight::planTiles(nrow, ncol, tileSize, halo);
+  int n = tiles.size();
+  IntegerVector row(n), col(n), tileNrow(n), tileNcol(n), windowRow(n), windowCol(n), windowNrow(n), windowNcol(n);
+  for (int t = 0; t < n; t++) {
+    row[t] = tiles[t].row + 1;
+    col[t] = tiles[t].col + 1;
+    tileNrow[t] = tiles[t].nrow;
+    tileNcol[t] = tiles[t].ncol;
+    windowRow[t] = tiles[t].windowRow + 1;
+    windowCol[t] = tiles[t].windowCol + 1;
+    windowNrow[t] = tiles[t].windowNrow;
+    windowNcol[t] = tiles[t].windowNcol;
+  }
+  DataFrame result = DataFrame::create(
+    _["row"] = row,
+    _["col"] = col,
+    _["nrow"] = tileNrow,
+    _["ncol"] = tileNcol,
+    _["window_row"] = windowRow,
+    _["window_col"] = windowCol,
+    _["window_nrow"] = windowNrow,
+    _["window_ncol"] = windowNcol
+  );
+  result.attr("halo") = halo;
+  return result;
 }
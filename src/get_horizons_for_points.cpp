@@ -0,0 +1,133 @@
+// [[Rcpp::depends(RcppParallel)]]
+#include "sunlight_rcpp.h"
+#include <string>
+#include <sunlight/store.h>
+#include <vector>
+
+using namespace Rcpp;
+using namespace RcppParallel;
+
+// horizon profiles of points x/y of a dem, computed for those points only:
+// no horizons of the rest of the grid, so a few hundred sites take seconds
+// where a precomputed cube takes hours. georeference is c(xmin, ymax, xres,
+// yres) of the dem, azimuths run from azimuthMin to azimuthMax by
+// azimuthStep, the other settings as for get_altitudes_for_azimuths_cpp
+// (with method march), dem a matrix or a session of dem_session_cpp.
+// returns a list of
+//   profiles  nAzimuths x nPoints matrix of horizon angles in degrees, a
+//             column per point, NaN outside the dem and on NA cells, with
+//             attribute azimuths
+//   rows/cols the cell of each point, NA outside the dem
+//   durations with timestep > 0, the minutes of daylight timesteps of
+//             timestep minutes from timeStart to timeStop (POSIXct) in
+//             which each point is lit, the sun taken at location lat/lon of
+//             each point (or one for all) and at the nearest azimuth of its
+//             profile; NaN outside the dem and on NA cells
+// points and azimuths are spread over numThreads threads (-1 for all)
+//' @export
+// [[Rcpp::export]]
+List get_horizons_for_points_cpp(
+    SEXP dem,
+    NumericVector x,
+    NumericVector y,
+    NumericVector georeference,
+    double azimuthMin,
+    double azimuthMax,
+    double azimuthStep,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    bool prune = true,
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> lat = R_NilValue,
+    Rcpp::Nullable<NumericVector> lon = R_NilValue,
+    double timeStart = 0,
+    double timeStop = 0,
+    double timestep = 0,
+    int numThreads = -1
+  ) {
+  if (y.size() != x.size()) {
+    Rcpp::stop("x and y must have the same length");
+  }
+  if (georeference.size() != 4) {
+    Rcpp::stop("georeference must be c(xmin, ymax, xres, yres)");
+  }
+  std::vector<double> azimuths = azimuthRange(azimuthMin, azimuthMax, azimuthStep);
+  int nAzimuths = azimuths.size();
+  int nPoints = x.size();
+  DemArgument input(dem);
+  sunlight::GridView<const double> view = input.view();
+
+  std::vector<sunlight::GridPoint> points(nPoints);
+  IntegerVector rows(nPoints, NA_INTEGER), cols(nPoints, NA_INTEGER);
+  for (int i = 0; i < nPoints; i++) {
+    sunlight::GridPoint point = {-1, -1};
+    if (sunlight::gridCellAt(x[i], y[i], georeference[0], georeference[1], georeference[2], georeference[3], view.nrow, view.ncol, point.row, point.col)) {
+      rows[i] = point.row + 1;
+      cols[i] = point.col + 1;
+    }
+    points[i] = point;
+  }
+
+  NumericMatrix profiles(nAzimuths, nPoints);
+  sunlight::PointHorizonJob<double> job(
+    view,
+    points,
+    profiles.begin(),
+    azimuths,
+    gridConvergence,
+    resolution,
+    incFactor,
+    prune,
+    correctCurvature,
+    correctRefraction,
+    input.summary(prune)
+  );
+  runJob(job, numThreads);
+  profiles.attr("azimuths") = NumericVector(azimuths.begin(), azimuths.end());
+
+  if (timestep <= 0) {
+    return List::create(
+      _["profiles"] = profiles,
+      _["rows"] = rows,
+      _["cols"] = cols
+    );
+  }
+
+  // the profiles are a horizon cube of an nPoints x 1 grid, queried as a
+  // store would be
+  if (lat.isNull() || lon.isNull()) {
+    Rcpp::stop("durations need lat and lon");
+  }
+  NumericVector latitudes(lat), longitudes(lon);
+  if ((latitudes.size() != x.size() && latitudes.size() != 1) || longitudes.size() != latitudes.size()) {
+    Rcpp::stop("lat and lon must have the length of x, or length 1");
+  }
+  sunlight::StoreHeader header = sunlight::StoreHeader();
+  header.nAzimuths = nAzimuths;
+  header.nrow = nPoints;
+  header.ncol = 1;
+  header.azimuthMin = azimuths[0];
+  header.azimuthStep = azimuthStep;
+  std::vector<sunlight::StorePoint> profilePoints(nPoints);
+  for (int i = 0; i < nPoints; i++) {
+    int k = latitudes.size() == 1 ? 0 : i;
+    bool known = points[i].row >= 0 && !sunlight::isNA(view(points[i].row, points[i].col));
+    sunlight::StorePoint point = {known ? i : -1, 0, latitudes[k], longitudes[k]};
+    profilePoints[i] = point;
+  }
+  std::vector<double> queryTimes;
+  for (long step = 0; timeStart + step * timestep * 60 < timeStop; step++) {
+    queryTimes.push_back(timeStart + step * timestep * 60);
+  }
+  NumericVector durations(nPoints);
+  sunlight::PointQueryJob<double> query(header, profiles.begin(), profilePoints, queryTimes, false, NULL, NA_LOGICAL, durations.begin(), timestep);
+  runJob(query, numThreads);
+  return List::create(
+    _["profiles"] = profiles,
+    _["rows"] = rows,
+    _["cols"] = cols,
+    _["durations"] = durations
+  );
+}
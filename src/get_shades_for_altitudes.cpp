@@ -1,7 +1,6 @@
-#include <Rcpp.h>
+#include "sunlight_rcpp.h"
 #include <cmath>
 #include <vector>
-// #include <algorithm>    // std::transform
 
 using namespace Rcpp;
 
@@ -15,37 +14,40 @@ using namespace Rcpp;
 // };
 
 
+// shade (1) per cell of an altitude layer for a sun at minAltitude, or with
+// packed a shade mask of 1 bit per cell (see mask_dim, get_mask_layer_cpp).
+// with horizon_ranges (see get_altitudes_for_azimuths_cpp) only the cells of
+// tiles the sun is within the range of are compared
 //' @export
 // [[Rcpp::export]]
-NumericMatrix get_shades_for_altitudes_cpp(
-    NumericMatrix& altitudes,
-    double minAltitude
+SEXP get_shades_for_altitudes_cpp(
+    SEXP altitudes,
+    double minAltitude,
+    bool packed = false
   ) {
+  return thresholdLayer(altitudes, minAltitude, false, packed, false);
+}
 
-  // remember shape
-  int width = altitudes.ncol();
-  int height = altitudes.nrow();
-
-  // initialize result matrix
-  NumericMatrix shadeMatrix(height, width);
-
-  for(int col = 0; col < width; col++) {
-    for(int row = 0; row < height; row++) {
-      if (minAltitude < altitudes(row, col)) {
-        shadeMatrix(row, col) = 1;
-      } else {
-        shadeMatrix(row, col) = 0;
-      }
-    }
+// layer index (1-based) of a mask or stack of masks as a 0/1 matrix
+//' @export
+// [[Rcpp::export]]
+NumericMatrix get_mask_layer_cpp(
+    RawVector mask,
+    int index = 1
+  ) {
+  if (!mask.hasAttribute("mask_dim")) {
+    Rcpp::stop("mask needs a mask_dim attribute");
   }
-  // alt implementation
-  //
-  // std::transform(
-  //   altitudes.begin(),
-  //   altitudes.end(),
-  //   shadeMatrix.begin(),
-  //   [minAltitude] (int value) { if (minAltitude < value) { return 1; } else { return 0; }}
-  // );
-
-  return shadeMatrix;
+  IntegerVector dim = as<IntegerVector>(mask.attr("mask_dim"));
+  int nMasks = dim.size() == 3 ? dim[2] : 1;
+  if (index < 1 || index > nMasks) {
+    Rcpp::stop("mask index out of range");
+  }
+  std::size_t nCells = (std::size_t)dim[0] * dim[1];
+  const uint64_t* words = maskData(mask) + (index - 1) * sunlight::maskWords(nCells);
+  NumericMatrix layer(dim[0], dim[1]);
+  for (std::size_t i = 0; i < nCells; i++) {
+    layer[i] = (words[i / 64] >> (i % 64)) & 1;
+  }
+  return layer;
 }
@@ -0,0 +1,121 @@
+// [[Rcpp::depends(RcppParallel)]]
+#include "sunlight_rcpp.h"
+#include <string>
+#include <sunlight/store.h>
+#include <vector>
+
+using namespace Rcpp;
+using namespace RcppParallel;
+
+// points x/y in the coordinates of the store's dem, with the location lat/lon
+// of each (or one for all) for the sun
+std::vector<sunlight::StorePoint> storePoints(
+    const sunlight::HorizonStore& store,
+    NumericVector x,
+    NumericVector y,
+    NumericVector lat,
+    NumericVector lon
+  ) {
+  if (y.size() != x.size()) {
+    Rcpp::stop("x and y must have the same length");
+  }
+  if ((lat.size() != x.size() && lat.size() != 1) || lon.size() != lat.size()) {
+    Rcpp::stop("lat and lon must have the length of x, or length 1");
+  }
+  std::vector<sunlight::StorePoint> points(x.size());
+  for (R_xlen_t i = 0; i < x.size(); i++) {
+    R_xlen_t k = lat.size() == 1 ? 0 : i;
+    sunlight::StorePoint point = {-1, -1, lat[k], lon[k]};
+    store.cellAt(x[i], y[i], point.row, point.col);
+    points[i] = point;
+  }
+  return points;
+}
+
+template <typename T>
+void queryStore(
+    const sunlight::HorizonStore& store,
+    const std::vector<sunlight::StorePoint>& points,
+    const std::vector<double>& times,
+    bool correctRefraction,
+    int* shades,
+    double* durations,
+    double weight
+  ) {
+  sunlight::PointQueryJob<T> job(store, points, times, correctRefraction, shades, NA_LOGICAL, durations, weight);
+  runJob(job);
+}
+
+// dispatch on the storage type of the store
+void queryStore(
+    const sunlight::HorizonStore& store,
+    const std::vector<sunlight::StorePoint>& points,
+    const std::vector<double>& times,
+    bool correctRefraction,
+    int* shades,
+    double* durations,
+    double weight
+  ) {
+  switch (store.getHeader().type) {
+  case 1:
+    queryStore<uint16_t>(store, points, times, correctRefraction, shades, durations, weight);
+    break;
+  case 2:
+    queryStore<uint8_t>(store, points, times, correctRefraction, shades, durations, weight);
+    break;
+  default:
+    queryStore<double>(store, points, times, correctRefraction, shades, durations, weight);
+  }
+}
+
+// shade flags of points x/y at times (POSIXct) from the horizon store at
+// path, as a points x times matrix: TRUE if the sun is below the horizon of
+// the point, NA outside the dem and for sun azimuths outside the store
+//' @export
+// [[Rcpp::export]]
+LogicalMatrix get_shades_for_points_cpp(
+    std::string path,
+    NumericVector x,
+    NumericVector y,
+    NumericVector lat,
+    NumericVector lon,
+    NumericVector times,
+    bool correctRefraction = false
+  ) {
+  sunlight::HorizonStore store(path);
+  std::vector<sunlight::StorePoint> points = storePoints(store, x, y, lat, lon);
+  std::vector<double> queryTimes(times.begin(), times.end());
+  LogicalMatrix shades(x.size(), times.size());
+  queryStore(store, points, queryTimes, correctRefraction, shades.begin(), NULL, 0);
+  return shades;
+}
+
+// sunlight of points x/y from timeStart to timeStop (POSIXct) in timesteps of
+// timestep minutes, from the horizon store at path: the minutes of daylight
+// timesteps in which each point is lit, NaN outside the dem
+//' @export
+// [[Rcpp::export]]
+NumericVector get_sunlight_duration_for_points_cpp(
+    std::string path,
+    NumericVector x,
+    NumericVector y,
+    NumericVector lat,
+    NumericVector lon,
+    double timeStart,
+    double timeStop,
+    double timestep,
+    bool correctRefraction = false
+  ) {
+  if (timestep <= 0) {
+    Rcpp::stop("invalid timestep");
+  }
+  sunlight::HorizonStore store(path);
+  std::vector<sunlight::StorePoint> points = storePoints(store, x, y, lat, lon);
+  std::vector<double> queryTimes;
+  for (long step = 0; timeStart + step * timestep * 60 < timeStop; step++) {
+    queryTimes.push_back(timeStart + step * timestep * 60);
+  }
+  NumericVector durations(x.size());
+  queryStore(store, points, queryTimes, correctRefraction, NULL, durations.begin(), timestep);
+  return durations;
+}
@@ -0,0 +1,58 @@
+// [[Rcpp::depends(RcppParallel)]]
+#include "sunlight_rcpp.h"
+#include <vector>
+
+using namespace Rcpp;
+using namespace RcppParallel;
+
+// shade (1) per cell of a dem for a sun at azimuth and altitude (degrees),
+// cast straight from the dem in one pass (see sunlight/shadow.h): no horizon
+// cube, and the exact azimuth instead of the nearest precomputed one. the
+// same shades as get_shades_for_altitudes_cpp on a sweep layer of azimuth.
+// with sunlight, sunlight (1) instead; with packed, a mask of 1 bit per cell
+// (see get_mask_layer_cpp). dem is a matrix or a session of
+// dem_session_cpp. runs on numThreads threads (-1 for all)
+//' @export
+// [[Rcpp::export]]
+SEXP get_shades_for_sun_position_cpp(
+    SEXP dem,
+    double azimuth,
+    double altitude,
+    double gridConvergence,
+    double resolution,
+    bool sunlight = false,
+    bool packed = false,
+    int numThreads = -1
+  ) {
+  DemArgument input(dem);
+  sunlight::GridView<const double> view = input.view();
+  if (packed) {
+    // lines cross the words of a mask, so cells go to bytes first
+    std::vector<unsigned char> flags(view.size());
+    sunlight::ShadowJob<double, unsigned char> job(
+      view,
+      sunlight::GridView<unsigned char>(flags.data(), view.nrow, view.ncol),
+      azimuth,
+      altitude,
+      gridConvergence,
+      resolution,
+      sunlight
+    );
+    runJob(job, numThreads);
+    RawVector mask = allocateMask(view.nrow, view.ncol, 1, sunlight);
+    sunlight::packMask(flags.data(), flags.size(), maskData(mask));
+    return mask;
+  }
+  NumericMatrix shades(view.nrow, view.ncol);
+  sunlight::ShadowJob<double, double> job(
+    view,
+    sunlight::GridView<double>(shades.begin(), view.nrow, view.ncol),
+    azimuth,
+    altitude,
+    gridConvergence,
+    resolution,
+    sunlight
+  );
+  runJob(job, numThreads);
+  return shades;
+}
@@ -0,0 +1,99 @@
+#include "sunlight_rcpp.h"
+#include <vector>
+
+using namespace Rcpp;
+
+// times as R POSIXct in UTC
+NumericVector utcTimes(const std::vector<double>& seconds) {
+  NumericVector times(seconds.begin(), seconds.end());
+  times.attr("class") = CharacterVector::create("POSIXct", "POSIXt");
+  times.attr("tzone") = "UTC";
+  return times;
+}
+
+// sun azimuth (degrees clockwise from north, as for the altitude kernels) and
+// altitude (degrees) at times (POSIXct) for a location, apparent altitudes
+// with correctRefraction. daylight is TRUE between sunrise and sunset
+//' @export
+// [[Rcpp::export]]
+DataFrame get_sun_positions_cpp(
+    NumericVector times,
+    double lat,
+    double lon,
+    bool correctRefraction = false
+  ) {
+  int n = times.size();
+  NumericVector azimuths(n);
+  NumericVector altitudes(n);
+  LogicalVector daylight(n);
+  for (int i = 0; i < n; i++) {
+    if (sunlight::isNA(times[i])) {
+      azimuths[i] = NA_REAL;
+      altitudes[i] = NA_REAL;
+      daylight[i] = NA_LOGICAL;
+      continue;
+    }
+    sunlight::SunPosition position = sunlight::getSunPosition(times[i], lat, lon);
+    daylight[i] = position.altitude >= sunlight::sunriseAltitude;
+    if (correctRefraction) {
+      position.altitude += sunlight::getAtmosphericRefraction(position.altitude);
+    }
+    azimuths[i] = position.azimuth;
+    altitudes[i] = position.altitude;
+  }
+  return DataFrame::create(
+    _["azimuth"] = azimuths,
+    _["altitude"] = altitudes,
+    _["daylight"] = daylight
+  );
+}
+
+// sunrise, solar noon and sunset (POSIXct, UTC) for dates (Date, as UTC
+// days) at a location. sunrise and sunset are NA on polar days and nights,
+// polar tells which (1 day, -1 night, 0 otherwise)
+//' @export
+// [[Rcpp::export]]
+DataFrame get_sunlight_times_cpp(
+    NumericVector dates,
+    double lat,
+    double lon
+  ) {
+  int n = dates.size();
+  std::vector<double> sunrise(n);
+  std::vector<double> noon(n);
+  std::vector<double> sunset(n);
+  IntegerVector polar(n);
+  for (int i = 0; i < n; i++) {
+    sunlight::SunlightTimes times = sunlight::getSunlightTimes(floor(dates[i]) * 86400, lat, lon);
+    sunrise[i] = times.sunrise;
+    noon[i] = times.noon;
+    sunset[i] = times.sunset;
+    polar[i] = times.polar;
+  }
+  return DataFrame::create(
+    _["date"] = dates,
+    _["sunrise"] = utcTimes(sunrise),
+    _["noon"] = utcTimes(noon),
+    _["sunset"] = utcTimes(sunset),
+    _["polar"] = polar
+  );
+}
+
+// highest apparent (with correctRefraction) sun altitude in degrees over any
+// year at latitude lat, per azimuth of azimuthWidth degrees centred on
+// azimuths: the caps for the altitude kernels, -90 where the sun never
+// stands, 90 where it can reach the zenith
+//' @export
+// [[Rcpp::export]]
+NumericVector get_max_sun_altitudes_cpp(
+    NumericVector azimuths,
+    double lat,
+    double azimuthWidth = 0,
+    bool correctRefraction = true
+  ) {
+  NumericVector caps(azimuths.size());
+  for (R_xlen_t a = 0; a < azimuths.size(); a++) {
+    caps[a] = sunlight::getMaxSunAltitude(azimuths[a], lat, azimuthWidth / 2, correctRefraction);
+  }
+  return caps;
+}
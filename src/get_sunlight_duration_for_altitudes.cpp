@@ -0,0 +1,321 @@
+// [[Rcpp::depends(RcppParallel)]]
+#include "sunlight_rcpp.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Rcpp;
+using namespace RcppParallel;
+
+// the durations of samples added up into durationMatrix, with the
+// horizon_ranges of source if it has them (see horizonRangesOf)
+template <typename T>
+void accumulateDurations(
+    SEXP source,
+    const T* altitudes,
+    int nLayers,
+    const std::vector<sunlight::SunSample>& samples,
+    NumericMatrix& durationMatrix
+  ) {
+  RMatrix<double> output(durationMatrix);
+  std::size_t nCells = (std::size_t)durationMatrix.nrow() * durationMatrix.ncol();
+  std::unique_ptr<sunlight::HorizonRanges<T> > ranges = horizonRangesOf<T>(source, nLayers, durationMatrix.nrow(), durationMatrix.ncol());
+  // (azimuth, row, col) cube: the layers of a cell are adjacent
+  sunlight::DurationJob<T> job(altitudes, nCells, 1, nLayers, samples, output.begin(), ranges.get());
+  runJob(job);
+}
+
+// total sunlight per cell for sun samples (layer, sunAltitude, weight), each
+// adding weight to the cells that are lit with the sun at sunAltitude in the
+// azimuth of layer: a 1-based index into an (azimuth, row, col) cube, or 1
+// for a single layer. durations, if given, holds the totals to add to. with
+// horizon_ranges (see get_altitudes_for_azimuths_cpp), tiles the sun is
+// outside the range of in every sample are added up whole
+//' @export
+// [[Rcpp::export]]
+NumericMatrix get_sunlight_duration_for_altitudes_cpp(
+    SEXP altitudes,
+    IntegerVector layers,
+    NumericVector sunAltitudes,
+    NumericVector weights,
+    Rcpp::Nullable<NumericMatrix> durations = R_NilValue
+  ) {
+  // remember shape
+  IntegerVector dim = horizonDimOf(altitudes);
+  if (dim.size() != 2 && dim.size() != 3) {
+    Rcpp::stop("altitudes must be a layer or a cube");
+  }
+  int nLayers = dim.size() == 3 ? dim[0] : 1;
+  int height = dim[dim.size() - 2];
+  int width = dim[dim.size() - 1];
+  if (layers.size() != sunAltitudes.size() || weights.size() != sunAltitudes.size()) {
+    Rcpp::stop("layers, sunAltitudes and weights must have the same length");
+  }
+  std::vector<sunlight::SunSample> samples(sunAltitudes.size());
+  for (R_xlen_t s = 0; s < sunAltitudes.size(); s++) {
+    if (layers[s] < 1 || layers[s] > nLayers) {
+      Rcpp::stop("layer out of range");
+    }
+    sunlight::SunSample sample = {layers[s] - 1, sunAltitudes[s], weights[s], NA_REAL};
+    samples[s] = sample;
+  }
+
+  // initialize result matrix
+  NumericMatrix durationMatrix(height, width);
+  if (durations.isNotNull()) {
+    NumericMatrix initial(durations);
+    if (initial.nrow() != height || initial.ncol() != width) {
+      Rcpp::stop("durations must match the altitudes");
+    }
+    std::copy(initial.begin(), initial.end(), durationMatrix.begin());
+  }
+
+  // compare in the storage type of the altitudes
+  std::string type = horizonTypeOf(altitudes);
+  if (type == "uint16") {
+    RawVector counts(altitudes);
+    accumulateDurations(altitudes, quantizedData<uint16_t>(counts), nLayers, samples, durationMatrix);
+  } else if (type == "uint8") {
+    RawVector counts(altitudes);
+    accumulateDurations(altitudes, quantizedData<uint8_t>(counts), nLayers, samples, durationMatrix);
+  } else {
+    NumericVector angles(altitudes);
+    accumulateDurations<double>(altitudes, angles.begin(), nLayers, samples, durationMatrix);
+  }
+
+  return durationMatrix;
+}
+
+// azimuth step of an (azimuth, row, col) cube as returned by
+// get_altitudes_for_azimuths_cpp
+double cubeAzimuthStep(SEXP altitudes) {
+  IntegerVector dim = horizonDimOf(altitudes);
+  RObject cube(altitudes);
+  if (dim.size() != 3 || !cube.hasAttribute("azimuths")) {
+    Rcpp::stop("altitudes must be a cube with azimuths");
+  }
+  NumericVector azimuths = as<NumericVector>(cube.attr("azimuths"));
+  double azimuthStep = 0;
+  if (cube.hasAttribute("azimuth_step")) {
+    azimuthStep = as<double>(cube.attr("azimuth_step"));
+  } else if (azimuths.size() > 1) {
+    azimuthStep = azimuths[1] - azimuths[0];
+  }
+  if (azimuthStep <= 0) {
+    Rcpp::stop("invalid azimuth step");
+  }
+  return azimuthStep;
+}
+
+// sun samples of the daylight timesteps from timeStart to timeStop (POSIXct)
+// every timestep minutes at location lat/lon, each assigned to the nearest
+// azimuth of a cube (see cubeAzimuthStep) and weighing timestep
+std::vector<sunlight::SunSample> periodSamples(
+    SEXP altitudes,
+    double timeStart,
+    double timeStop,
+    double timestep,
+    double lat,
+    double lon
+  ) {
+  double azimuthStep = cubeAzimuthStep(altitudes);
+  if (timestep <= 0) {
+    Rcpp::stop("invalid timestep");
+  }
+  IntegerVector dim = horizonDimOf(altitudes);
+  NumericVector azimuths = as<NumericVector>(RObject(altitudes).attr("azimuths"));
+  return sunlight::getSunSamples(
+    timeStart,
+    timeStop,
+    timestep * 60,
+    timestep,
+    lat,
+    lon,
+    azimuths[0],
+    azimuthStep,
+    dim[0]
+  );
+}
+
+// total sunlight per cell from timeStart to timeStop (POSIXct) in timesteps
+// of timestep minutes, at location lat/lon, for an (azimuth, row, col) cube
+// as returned by get_altitudes_for_azimuths_cpp. the sun positions are
+// computed in C++ and each daylight timestep is assigned to the nearest
+// azimuth of the cube; the result is in minutes. horizon_ranges of the cube
+// are used as for get_sunlight_duration_for_altitudes_cpp
+//' @export
+// [[Rcpp::export]]
+NumericMatrix get_sunlight_duration_for_period_cpp(
+    SEXP altitudes,
+    double timeStart,
+    double timeStop,
+    double timestep,
+    double lat,
+    double lon
+  ) {
+  std::vector<sunlight::SunSample> samples = periodSamples(altitudes, timeStart, timeStop, timestep, lat, lon);
+  IntegerVector dim = horizonDimOf(altitudes);
+  NumericMatrix durationMatrix(dim[1], dim[2]);
+  std::string type = horizonTypeOf(altitudes);
+  if (type == "uint16") {
+    RawVector counts(altitudes);
+    accumulateDurations(altitudes, quantizedData<uint16_t>(counts), dim[0], samples, durationMatrix);
+  } else if (type == "uint8") {
+    RawVector counts(altitudes);
+    accumulateDurations(altitudes, quantizedData<uint8_t>(counts), dim[0], samples, durationMatrix);
+  } else {
+    NumericVector angles(altitudes);
+    accumulateDurations<double>(altitudes, angles.begin(), dim[0], samples, durationMatrix);
+  }
+
+  return durationMatrix;
+}
+
+template <typename T>
+void computeMasks(
+    const T* altitudes,
+    std::size_t nCells,
+    int nLayers,
+    const std::vector<sunlight::SunSample>& samples,
+    bool sunlight,
+    RawVector& masks
+  ) {
+  sunlight::MaskCubeJob<T> job(altitudes, nCells, 1, nLayers, samples, sunlight, maskData(masks));
+  runJob(job);
+}
+
+// shade masks (see get_shades_for_altitudes_cpp) of the daylight timesteps
+// from timeStart to timeStop (POSIXct) every timestep minutes at location
+// lat/lon, for a cube as for get_sunlight_duration_for_period_cpp, or with
+// sunlight sunlight masks: one bit per cell and timestep, so a day of 10
+// minute shade maps of a 10000 x 10000 dem takes about 1 GB instead of 70.
+// attributes times (POSIXct seconds), azimuths and altitudes hold the sun of
+// each mask, cells the number of cells set in it and timestep the minutes
+// each mask stands for (see get_duration_for_masks_cpp)
+//' @export
+// [[Rcpp::export]]
+RawVector get_shade_masks_for_period_cpp(
+    SEXP altitudes,
+    double timeStart,
+    double timeStop,
+    double timestep,
+    double lat,
+    double lon,
+    bool sunlight = false
+  ) {
+  std::vector<sunlight::SunSample> samples = periodSamples(altitudes, timeStart, timeStop, timestep, lat, lon);
+  IntegerVector dim = horizonDimOf(altitudes);
+  std::size_t nCells = (std::size_t)dim[1] * dim[2];
+  int nMasks = samples.size();
+  RawVector masks = allocateMask(dim[1], dim[2], nMasks, sunlight);
+  // a stack even of a single mask
+  masks.attr("mask_dim") = IntegerVector::create(dim[1], dim[2], nMasks);
+  std::string type = horizonTypeOf(altitudes);
+  if (type == "uint16") {
+    RawVector counts(altitudes);
+    computeMasks(quantizedData<uint16_t>(counts), nCells, dim[0], samples, sunlight, masks);
+  } else if (type == "uint8") {
+    RawVector counts(altitudes);
+    computeMasks(quantizedData<uint8_t>(counts), nCells, dim[0], samples, sunlight, masks);
+  } else {
+    NumericVector angles(altitudes);
+    computeMasks<double>(angles.begin(), nCells, dim[0], samples, sunlight, masks);
+  }
+
+  NumericVector cubeAzimuths = as<NumericVector>(RObject(altitudes).attr("azimuths"));
+  NumericVector times(nMasks), azimuths(nMasks), sunAltitudes(nMasks), cells(nMasks);
+  std::size_t nWords = sunlight::maskWords(nCells);
+  for (int s = 0; s < nMasks; s++) {
+    times[s] = samples[s].time;
+    azimuths[s] = cubeAzimuths[samples[s].layer];
+    sunAltitudes[s] = samples[s].altitude;
+    cells[s] = sunlight::countMaskCells(maskData(masks) + s * nWords, nWords);
+  }
+  masks.attr("times") = times;
+  masks.attr("azimuths") = azimuths;
+  masks.attr("altitudes") = sunAltitudes;
+  masks.attr("cells") = cells;
+  masks.attr("timestep") = timestep;
+  return masks;
+}
+
+// per cell number of masks of a stack of masks it is set in, times the
+// timestep attribute (1 if missing): with the sunlight masks of
+// get_shade_masks_for_period_cpp the sunlight duration in minutes, as
+// get_sunlight_duration_for_period_cpp
+//' @export
+// [[Rcpp::export]]
+NumericMatrix get_duration_for_masks_cpp(
+    RawVector masks
+  ) {
+  if (!masks.hasAttribute("mask_dim")) {
+    Rcpp::stop("masks need a mask_dim attribute");
+  }
+  IntegerVector dim = as<IntegerVector>(masks.attr("mask_dim"));
+  int nMasks = dim.size() == 3 ? dim[2] : 1;
+  double weight = masks.hasAttribute("timestep") ? as<double>(masks.attr("timestep")) : 1;
+  NumericMatrix durationMatrix(dim[0], dim[1]);
+  RMatrix<double> output(durationMatrix);
+  sunlight::MaskDurationJob job(maskData(masks), nMasks, (std::size_t)dim[0] * dim[1], weight, output.begin());
+  runJob(job);
+  return durationMatrix;
+}
+
+template <typename T>
+void computeSunrise(
+    const T* altitudes,
+    std::size_t nCells,
+    int nLayers,
+    const std::vector<sunlight::TrackKnot>& knots,
+    NumericMatrix& sunrise,
+    NumericMatrix& sunset,
+    NumericMatrix& duration
+  ) {
+  RMatrix<double> rise(sunrise), set(sunset), lit(duration);
+  sunlight::SunriseJob<T> job(altitudes, nCells, 1, nLayers, knots, rise.begin(), set.begin(), lit.begin());
+  runJob(job);
+}
+
+// terrain sunrise and sunset (POSIXct seconds, NA for cells never lit) and
+// sunlight duration (minutes) per cell from timeStart to timeStop, usually
+// a day, at location lat/lon for a cube as for
+// get_sunlight_duration_for_period_cpp. no timesteps: the crossings of the
+// sun's track with each cell's horizon, interpolated between the azimuths of
+// the cube, are found directly (see sunlight/sunrise.h), to within seconds
+//' @export
+// [[Rcpp::export]]
+List get_terrain_sunlight_for_period_cpp(
+    SEXP altitudes,
+    double timeStart,
+    double timeStop,
+    double lat,
+    double lon
+  ) {
+  double azimuthStep = cubeAzimuthStep(altitudes);
+  IntegerVector dim = horizonDimOf(altitudes);
+  NumericVector azimuths = as<NumericVector>(RObject(altitudes).attr("azimuths"));
+  std::vector<sunlight::TrackKnot> knots = sunlight::getSunTrack(timeStart, timeStop, lat, lon, azimuths[0], azimuthStep, dim[0]);
+
+  NumericMatrix sunrise(dim[1], dim[2]), sunset(dim[1], dim[2]), duration(dim[1], dim[2]);
+  std::size_t nCells = (std::size_t)dim[1] * dim[2];
+  std::string type = horizonTypeOf(altitudes);
+  if (type == "uint16") {
+    RawVector counts(altitudes);
+    computeSunrise(quantizedData<uint16_t>(counts), nCells, dim[0], knots, sunrise, sunset, duration);
+  } else if (type == "uint8") {
+    RawVector counts(altitudes);
+    computeSunrise(quantizedData<uint8_t>(counts), nCells, dim[0], knots, sunrise, sunset, duration);
+  } else {
+    NumericVector angles(altitudes);
+    computeSunrise<double>(angles.begin(), nCells, dim[0], knots, sunrise, sunset, duration);
+  }
+  // seconds to minutes
+  for (std::size_t i = 0; i < nCells; i++) {
+    duration[i] /= 60;
+  }
+  return List::create(
+    _["sunrise"] = sunrise,
+    _["sunset"] = sunset,
+    _["duration"] = duration
+  );
+}
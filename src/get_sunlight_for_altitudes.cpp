@@ -1,32 +1,17 @@
-#include <Rcpp.h>
+#include "sunlight_rcpp.h"
 #include <cmath>
 #include <vector>
 
 using namespace Rcpp;
 
+// sunlight (1) per cell of an altitude layer for a sun at minAltitude, or
+// with packed a sunlight mask of 1 bit per cell
 //' @export
 // [[Rcpp::export]]
-NumericMatrix get_sunlight_for_altitudes_cpp(
-    NumericMatrix& altitudes,
-    double minAltitude
+SEXP get_sunlight_for_altitudes_cpp(
+    SEXP altitudes,
+    double minAltitude,
+    bool packed = false
   ) {
-
-  // remember shape
-  int width = altitudes.ncol();
-  int height = altitudes.nrow();
-
-  // initialize result matrix
-  NumericMatrix sunlightMatrix(height, width);
-
-  for(int col = 0; col < width; col++) {
-    for(int row = 0; row < height; row++) {
-      if (minAltitude < altitudes(row, col)) {
-        sunlightMatrix(row, col) = 0;
-      } else {
-        sunlightMatrix(row, col) = 1;
-      }
-    }
-  }
-
-  return sunlightMatrix;
+  return thresholdLayer(altitudes, minAltitude, true, packed, false);
 }
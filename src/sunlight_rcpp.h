@@ -0,0 +1,346 @@
+#ifndef SUNLIGHTRCPP_SUNLIGHT_RCPP_H
+#define SUNLIGHTRCPP_SUNLIGHT_RCPP_H
+
+#include <RcppParallel.h>
+#include <Rcpp.h>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sunlight/sunlight.h>
+
+// glue between the R-free core in inst/include/sunlight and R: grid views on
+// R matrices, core jobs run through RcppParallel, and the R representation
+// of quantized altitudes. worker threads only ever see the raw views
+
+// column-major view of an R matrix, which must outlive the view
+template <typename T>
+inline sunlight::GridView<T> gridView(RcppParallel::RMatrix<T>& matrix) {
+  return sunlight::GridView<T>(matrix.begin(), matrix.nrow(), matrix.ncol());
+}
+
+// adapts a core job, callable on a task range [begin, end) and exposing
+// size(), to RcppParallel
+template <typename Job>
+struct JobWorker : public RcppParallel::Worker {
+  const Job& job;
+
+  JobWorker(const Job& job) : job(job) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    job(begin, end);
+  }
+};
+
+template <typename Job>
+inline void runJob(const Job& job, int numThreads = -1) {
+  JobWorker<Job> worker(job);
+  RcppParallel::parallelFor(0, job.size(), worker, 1, numThreads);
+}
+
+// the dem argument of a kernel: a numeric matrix, used in place for the
+// call, or a session of dem_session_cpp (see sunlight::DemSession), whose
+// copy of the dem and summary are kept across calls
+class DemArgument {
+public:
+  explicit DemArgument(SEXP dem) :
+    session(NULL) {
+    if (TYPEOF(dem) == EXTPTRSXP) {
+      session = Rcpp::XPtr<sunlight::DemSession>(dem).get();
+      if (session == NULL) {
+        Rcpp::stop("dem session is no longer valid");
+      }
+    } else {
+      matrix = Rcpp::NumericMatrix(dem);
+    }
+  }
+
+  sunlight::GridView<const double> view() const {
+    if (session) {
+      return session->view();
+    }
+    return sunlight::GridView<const double>(matrix.begin(), matrix.nrow(), matrix.ncol());
+  }
+
+  int nrow() const {
+    return view().nrow;
+  }
+
+  int ncol() const {
+    return view().ncol;
+  }
+
+  // the session's summary, with its pyramid for pruned runs, or NULL for a
+  // matrix, whose kernels derive their own
+  const sunlight::DemSummary* summary(bool withPyramid) const {
+    return session ? &session->prepare(withPyramid) : NULL;
+  }
+
+private:
+  Rcpp::NumericMatrix matrix;
+  sunlight::DemSession* session;
+};
+
+// c(xmin, ymax, xres, yres) of a grid
+inline sunlight::Georeference georeferenceOf(Rcpp::NumericVector georeference) {
+  if (georeference.size() != 4) {
+    Rcpp::stop("georeference must be c(xmin, ymax, xres, yres)");
+  }
+  sunlight::Georeference result = {georeference[0], georeference[1], georeference[2], georeference[3]};
+  return result;
+}
+
+// the far fields of a horizon run (see sunlight::FarFieldJob), none for NULL
+// or else list(georeference = c(xmin, ymax, xres, yres) of the dem, dems =
+// list of coarser matrices, georeferences = list of their georeferences,
+// distances = increasing distances in m from which each is read). the
+// matrices are used in place for the call
+class FarFieldArgument {
+public:
+  explicit FarFieldArgument(Rcpp::Nullable<Rcpp::List> farField) {
+    if (farField.isNull()) {
+      return;
+    }
+    Rcpp::List list(farField);
+    georeference = georeferenceOf(list["georeference"]);
+    Rcpp::List dems = list["dems"];
+    Rcpp::List georeferences = list["georeferences"];
+    Rcpp::NumericVector distances = list["distances"];
+    R_xlen_t nFields = dems.size();
+    if (georeferences.size() != nFields || distances.size() != nFields) {
+      Rcpp::stop("far fields need a georeference and a distance per dem");
+    }
+    for (R_xlen_t f = 0; f < nFields; f++) {
+      matrices.push_back(Rcpp::NumericMatrix(dems[f]));
+      sunlight::FarField<double> field = {
+        sunlight::GridView<const double>(matrices[f].begin(), matrices[f].nrow(), matrices[f].ncol()),
+        georeferenceOf(Rcpp::NumericVector(georeferences[f])),
+        distances[f]
+      };
+      if (field.georeference.xres != field.georeference.yres) {
+        Rcpp::stop("far field cells must be square");
+      }
+      fields.push_back(field);
+    }
+  }
+
+  bool empty() const {
+    return fields.empty();
+  }
+
+  // distance up to which the run's own transects reach
+  double reach() const {
+    return fields.empty() ? INFINITY : fields[0].distance;
+  }
+
+  sunlight::Georeference georeference;
+  std::vector<sunlight::FarField<double> > fields;
+
+private:
+  std::vector<Rcpp::NumericMatrix> matrices;
+};
+
+// azimuthMin, azimuthMin + azimuthStep, ..., azimuthMax
+inline std::vector<double> azimuthRange(double azimuthMin, double azimuthMax, double azimuthStep) {
+  if (azimuthStep <= 0 || azimuthMax < azimuthMin) {
+    Rcpp::stop("invalid azimuth range");
+  }
+  int nAzimuths = floor((azimuthMax - azimuthMin) / azimuthStep + 1e-9) + 1;
+  std::vector<double> azimuths(nAzimuths);
+  for (int a = 0; a < nAzimuths; a++) {
+    azimuths[a] = azimuthMin + a * azimuthStep;
+  }
+  return azimuths;
+}
+
+// sun envelope caps per azimuth in degrees (see sunlight::neverSunlit),
+// none for NULL
+inline std::vector<double> altitudeCapsOf(Rcpp::Nullable<Rcpp::NumericVector> caps, std::size_t nAzimuths) {
+  if (caps.isNull()) {
+    return std::vector<double>();
+  }
+  Rcpp::NumericVector values(caps);
+  if ((std::size_t)values.size() != nAzimuths) {
+    Rcpp::stop("altitudeCaps must have one cap per azimuth");
+  }
+  return std::vector<double>(values.begin(), values.end());
+}
+
+// a quantized layer or cube is a raw vector holding the counts in native
+// byte order, with attributes
+//   horizon_type  "uint16" or "uint8"
+//   horizon_scale degrees per count
+//   horizon_dim   dimensions as for the unquantized result
+template <typename T>
+inline Rcpp::RawVector allocateQuantized(std::size_t n, Rcpp::IntegerVector dim) {
+  Rcpp::RawVector counts(n * sizeof(T));
+  counts.attr("horizon_type") = sunlight::HorizonType<T>::name();
+  counts.attr("horizon_scale") = sunlight::HorizonType<T>::scale();
+  counts.attr("horizon_dim") = dim;
+  return counts;
+}
+
+template <typename T>
+inline T* quantizedData(Rcpp::RawVector& counts) {
+  return reinterpret_cast<T*>(RAW(counts));
+}
+
+// "none", "uint16" or "uint8" for an altitudes object
+inline std::string horizonTypeOf(SEXP altitudes) {
+  if (TYPEOF(altitudes) != RAWSXP) {
+    return "none";
+  }
+  Rcpp::RObject object(altitudes);
+  if (!object.hasAttribute("horizon_type")) {
+    Rcpp::stop("raw altitudes need a horizon_type attribute");
+  }
+  std::string type = Rcpp::as<std::string>(object.attr("horizon_type"));
+  if (type != "uint16" && type != "uint8") {
+    Rcpp::stop("unknown horizon_type: " + type);
+  }
+  return type;
+}
+
+// dimensions of an altitudes object, quantized or not
+inline Rcpp::IntegerVector horizonDimOf(SEXP altitudes) {
+  Rcpp::RObject object(altitudes);
+  if (TYPEOF(altitudes) == RAWSXP) {
+    return Rcpp::as<Rcpp::IntegerVector>(object.attr("horizon_dim"));
+  }
+  return Rcpp::as<Rcpp::IntegerVector>(object.attr("dim"));
+}
+
+// a bit-packed mask or stack of masks (see sunlight/mask.h) is a raw
+// vector holding the 64-bit words of its masks one after the other in native
+// byte order, with attributes
+//   mask_type  "shade" or "sunlight", what a set bit means
+//   mask_dim   c(nrow, ncol), or c(nrow, ncol, nMasks) for a stack
+inline Rcpp::RawVector allocateMask(int nrow, int ncol, int nMasks, bool sunlight) {
+  std::size_t nWords = sunlight::maskWords((std::size_t)nrow * ncol);
+  Rcpp::RawVector mask(nWords * nMasks * sizeof(uint64_t));
+  mask.attr("mask_type") = sunlight ? "sunlight" : "shade";
+  if (nMasks == 1) {
+    mask.attr("mask_dim") = Rcpp::IntegerVector::create(nrow, ncol);
+  } else {
+    mask.attr("mask_dim") = Rcpp::IntegerVector::create(nrow, ncol, nMasks);
+  }
+  return mask;
+}
+
+inline uint64_t* maskData(Rcpp::RawVector& mask) {
+  return reinterpret_cast<uint64_t*>(RAW(mask));
+}
+
+// horizon ranges as attribute horizon_ranges: list(tile_size, min, max), min
+// and max with dim (nLayers, tileRows, tileCols) in the stored units (see
+// sunlight::HorizonRanges)
+template <typename T>
+inline Rcpp::List horizonRangesList(const sunlight::HorizonRanges<T>& ranges) {
+  Rcpp::IntegerVector dim = Rcpp::IntegerVector::create(ranges.nLayers, ranges.tileRows, ranges.tileCols);
+  Rcpp::NumericVector mins(ranges.mins.begin(), ranges.mins.end());
+  Rcpp::NumericVector maxs(ranges.maxs.begin(), ranges.maxs.end());
+  mins.attr("dim") = dim;
+  maxs.attr("dim") = dim;
+  return Rcpp::List::create(
+    Rcpp::_["tile_size"] = ranges.tileSize,
+    Rcpp::_["min"] = mins,
+    Rcpp::_["max"] = maxs
+  );
+}
+
+// the horizon ranges of an altitudes object, in its storage type, layer l of
+// cell i at altitudes[l * layerStride + i * cellStride]
+template <typename T>
+inline Rcpp::List horizonRangesList(const T* altitudes, int nLayers, int nrow, int ncol, std::ptrdiff_t layerStride, std::ptrdiff_t cellStride) {
+  sunlight::HorizonRanges<T> ranges(nrow, ncol, nLayers);
+  sunlight::HorizonRangeJob<T> job(altitudes, layerStride, cellStride, ranges);
+  runJob(job);
+  return horizonRangesList(ranges);
+}
+
+// the horizon_ranges attribute of altitudes with nLayers nrow x ncol layers
+// (see horizonRangesList), or NULL without one
+template <typename T>
+inline std::unique_ptr<sunlight::HorizonRanges<T> > horizonRangesOf(SEXP altitudes, int nLayers, int nrow, int ncol) {
+  Rcpp::RObject object(altitudes);
+  if (!object.hasAttribute("horizon_ranges")) {
+    return std::unique_ptr<sunlight::HorizonRanges<T> >();
+  }
+  Rcpp::List list = Rcpp::as<Rcpp::List>(object.attr("horizon_ranges"));
+  int tileSize = list["tile_size"];
+  Rcpp::NumericVector mins = list["min"];
+  Rcpp::NumericVector maxs = list["max"];
+  std::unique_ptr<sunlight::HorizonRanges<T> > ranges(new sunlight::HorizonRanges<T>(nrow, ncol, nLayers, tileSize));
+  if ((std::size_t)mins.size() != ranges->mins.size() || (std::size_t)maxs.size() != ranges->maxs.size()) {
+    Rcpp::stop("horizon_ranges do not match the altitudes");
+  }
+  std::copy(mins.begin(), mins.end(), ranges->mins.begin());
+  std::copy(maxs.begin(), maxs.end(), ranges->maxs.begin());
+  return ranges;
+}
+
+template <typename T>
+inline void thresholdInto(
+    const T* altitudes,
+    std::size_t nCells,
+    double minAltitude,
+    bool sunlight,
+    double* output,
+    uint64_t* mask,
+    bool parallel,
+    const sunlight::HorizonRanges<T>* ranges = NULL
+  ) {
+  sunlight::ThresholdJob<T> job = mask ?
+    sunlight::ThresholdJob<T>(altitudes, nCells, minAltitude, sunlight, mask, ranges) :
+    sunlight::ThresholdJob<T>(altitudes, nCells, minAltitude, sunlight, output, ranges);
+  if (parallel) {
+    runJob(job);
+  } else {
+    job(0, job.size());
+  }
+}
+
+// shades (or sunlight) of an altitude layer for a sun at minAltitude, as a
+// 0/1 matrix or, packed, a mask; on the calling thread unless parallel.
+// with horizon_ranges, tiles the sun is outside the range of are filled
+// whole
+inline SEXP thresholdLayer(SEXP altitudes, double minAltitude, bool sunlight, bool packed, bool parallel) {
+  // remember shape
+  Rcpp::IntegerVector dim = horizonDimOf(altitudes);
+  if (dim.size() != 2) {
+    Rcpp::stop("altitudes must be a single layer");
+  }
+  std::size_t nCells = (std::size_t)dim[0] * dim[1];
+  Rcpp::RObject result;
+  double* output = NULL;
+  uint64_t* mask = NULL;
+  if (packed) {
+    Rcpp::RawVector words = allocateMask(dim[0], dim[1], 1, sunlight);
+    mask = maskData(words);
+    result = words;
+  } else {
+    Rcpp::NumericMatrix matrix(dim[0], dim[1]);
+    output = matrix.begin();
+    result = matrix;
+  }
+  // compare in the storage type of the altitudes
+  std::string type = horizonTypeOf(altitudes);
+  if (type == "uint16") {
+    Rcpp::RawVector counts(altitudes);
+    std::unique_ptr<sunlight::HorizonRanges<uint16_t> > ranges = horizonRangesOf<uint16_t>(altitudes, 1, dim[0], dim[1]);
+    thresholdInto(quantizedData<uint16_t>(counts), nCells, minAltitude, sunlight, output, mask, parallel, ranges.get());
+  } else if (type == "uint8") {
+    Rcpp::RawVector counts(altitudes);
+    std::unique_ptr<sunlight::HorizonRanges<uint8_t> > ranges = horizonRangesOf<uint8_t>(altitudes, 1, dim[0], dim[1]);
+    thresholdInto(quantizedData<uint8_t>(counts), nCells, minAltitude, sunlight, output, mask, parallel, ranges.get());
+  } else {
+    Rcpp::NumericVector angles(altitudes);
+    std::unique_ptr<sunlight::HorizonRanges<double> > ranges = horizonRangesOf<double>(altitudes, 1, dim[0], dim[1]);
+    thresholdInto<double>(angles.begin(), nCells, minAltitude, sunlight, output, mask, parallel, ranges.get());
+  }
+  return result;
+}
+
+#endif
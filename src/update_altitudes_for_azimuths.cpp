@@ -0,0 +1,193 @@
+// [[Rcpp::depends(RcppParallel)]]
+#include "sunlight_rcpp.h"
+#include <memory>
+#include <string>
+#include <sunlight/store.h>
+#include <vector>
+
+using namespace Rcpp;
+using namespace RcppParallel;
+
+// box c(row, col, nrow, ncol), 1-based, of a dem
+sunlight::CellBox cellBox(IntegerVector box, const NumericMatrix& dem) {
+  if (box.size() != 4) {
+    Rcpp::stop("box must be c(row, col, nrow, ncol)");
+  }
+  sunlight::CellBox cells = {box[0] - 1, box[1] - 1, box[2], box[3]};
+  if (cells.row < 0 || cells.col < 0 || cells.nrow < 1 || cells.ncol < 1 ||
+      cells.row + cells.nrow > dem.nrow() || cells.col + cells.ncol > dem.ncol()) {
+    Rcpp::stop("box out of range of the dem");
+  }
+  return cells;
+}
+
+// far fields of an update, checked against the reach the altitudes were
+// computed with (0 without far fields)
+void checkFarField(const FarFieldArgument& far, double reach) {
+  if (reach > 0 && far.empty()) {
+    Rcpp::stop("the altitudes were computed with far fields, pass the same farField");
+  }
+  if (reach == 0 && !far.empty()) {
+    Rcpp::stop("the altitudes were computed without far fields");
+  }
+  if (reach > 0 && far.reach() != reach) {
+    Rcpp::stop("farField does not match the far fields the altitudes were computed with");
+  }
+}
+
+// run the core update job on output, returning the cells recomputed. with
+// far fields, the recomputed cells end at their reach and are raised by them
+template <typename T>
+double updateAltitudes(
+    NumericMatrix& dem,
+    T* output,
+    const std::vector<double>& azimuths,
+    const sunlight::CellBox& box,
+    double previousMax,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    bool correctRefraction,
+    double incFactor,
+    const std::string& method,
+    const std::vector<double>& altitudeCaps,
+    const FarFieldArgument& farField
+  ) {
+  RMatrix<double> input(dem);
+  std::unique_ptr<sunlight::FarFieldJob<double, T> > far;
+  if (!farField.empty()) {
+    far.reset(new sunlight::FarFieldJob<double, T>(
+        gridView(input),
+        farField.georeference,
+        farField.fields,
+        output,
+        azimuths,
+        gridConvergence,
+        incFactor,
+        correctCurvature,
+        correctRefraction,
+        altitudeCaps
+    ));
+  }
+  sunlight::UpdateJob<double, T> job(
+      gridView(input),
+      output,
+      azimuths,
+      gridConvergence,
+      resolution,
+      incFactor,
+      sunlight::parseMethod(method),
+      box,
+      previousMax,
+      correctCurvature,
+      correctRefraction,
+      altitudeCaps,
+      farField.reach(),
+      far.get()
+  );
+  if (job.effectiveMethod() != sunlight::parseMethod(method)) {
+    Rcpp::warning("sweep does not support curvature correction, using lines with incFactor 1");
+  }
+  runJob(job);
+  return job.updatedCells();
+}
+
+// horizon cube of get_altitudes_for_azimuths_cpp brought up to date with
+// dem after the cells in box, c(row, col, nrow, ncol) 1-based, were edited:
+// only cells the edit can affect are recomputed, with the settings the cube
+// was computed with, including its altitude_caps. previousMax is the highest
+// elevation in box before the edit, NA if unknown, which makes for more cells
+// to recompute. a cube computed with far fields (attribute far_field_reach)
+// needs the same farField. returns an updated copy with the number of cell
+// horizons recomputed as attribute updated_cells
+//' @export
+// [[Rcpp::export]]
+SEXP update_altitudes_for_azimuths_cpp(
+    NumericMatrix& dem,
+    SEXP altitudes,
+    IntegerVector box,
+    double previousMax,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    std::string method = "march",
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    Rcpp::Nullable<List> farField = R_NilValue
+  ) {
+  IntegerVector dim = horizonDimOf(altitudes);
+  RObject cube(altitudes);
+  if (dim.size() != 3 || !cube.hasAttribute("azimuths") || dim[1] != dem.nrow() || dim[2] != dem.ncol()) {
+    Rcpp::stop("altitudes must be a cube with azimuths for the dem");
+  }
+  NumericVector cubeAzimuths = as<NumericVector>(cube.attr("azimuths"));
+  std::vector<double> azimuths(cubeAzimuths.begin(), cubeAzimuths.end());
+  sunlight::CellBox cells = cellBox(box, dem);
+  // the caps the cube was computed with, unless given
+  std::vector<double> caps = altitudeCapsOf(altitudeCaps, azimuths.size());
+  if (altitudeCaps.isNull() && cube.hasAttribute("altitude_caps")) {
+    caps = altitudeCapsOf(Rcpp::Nullable<NumericVector>(as<NumericVector>(cube.attr("altitude_caps"))), azimuths.size());
+  }
+  FarFieldArgument far(farField);
+  checkFarField(far, cube.hasAttribute("far_field_reach") ? as<double>(cube.attr("far_field_reach")) : 0);
+
+  RObject updated(Rcpp::clone(altitudes));
+  std::string type = horizonTypeOf(altitudes);
+  double count;
+  if (type == "uint16") {
+    RawVector counts(updated);
+    count = updateAltitudes(dem, quantizedData<uint16_t>(counts), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  } else if (type == "uint8") {
+    RawVector counts(updated);
+    count = updateAltitudes(dem, quantizedData<uint8_t>(counts), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  } else {
+    NumericVector angles(updated);
+    count = updateAltitudes<double>(dem, angles.begin(), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  }
+  updated.attr("updated_cells") = count;
+  return updated;
+}
+
+// as update_altitudes_for_azimuths_cpp, in place on the horizon store at
+// path, with the caps the store was written with unless altitudeCaps are
+// given, and farField if the store was written with far fields; returns the
+// number of cell horizons recomputed
+//' @export
+// [[Rcpp::export]]
+double update_altitudes_store_cpp(
+    NumericMatrix& dem,
+    std::string path,
+    IntegerVector box,
+    double previousMax,
+    double gridConvergence,
+    double resolution,
+    bool correctCurvature,
+    double incFactor,
+    std::string method = "march",
+    bool correctRefraction = false,
+    Rcpp::Nullable<NumericVector> altitudeCaps = R_NilValue,
+    Rcpp::Nullable<List> farField = R_NilValue
+  ) {
+  sunlight::HorizonStore store(path, true);
+  const sunlight::StoreHeader& header = store.getHeader();
+  if (header.nrow != dem.nrow() || header.ncol != dem.ncol()) {
+    Rcpp::stop("the horizon store does not match the dem");
+  }
+  std::vector<double> azimuths(header.nAzimuths);
+  for (int a = 0; a < header.nAzimuths; a++) {
+    azimuths[a] = header.azimuthMin + a * header.azimuthStep;
+  }
+  sunlight::CellBox cells = cellBox(box, dem);
+  std::vector<double> caps = altitudeCaps.isNull() ? store.altitudeCaps() : altitudeCapsOf(altitudeCaps, azimuths.size());
+  FarFieldArgument far(farField);
+  checkFarField(far, header.farReach);
+  switch (header.type) {
+  case 1:
+    return updateAltitudes(dem, store.data<uint16_t>(), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  case 2:
+    return updateAltitudes(dem, store.data<uint8_t>(), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  default:
+    return updateAltitudes(dem, store.data<double>(), azimuths, cells, previousMax, gridConvergence, resolution, correctCurvature, correctRefraction, incFactor, method, caps, far);
+  }
+}